@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include <string>
 #include <iostream>
 #include <thread>
@@ -10,6 +11,7 @@
 #include "Storage.h"
 #include "scene/Settings.h"
 #include "Loop.h"
+#include "BatchSimulator.h"
 #include "scene/Scene.h"
 #include "helpers/Pose.h"
 #include "scene/Car.h"
@@ -21,12 +23,23 @@ PYBIND11_MODULE(pyspatzsim, m) {
         .def(pybind11::init())
         .def("load", [](Settings& self) { storage::load(self); })
         .def_readwrite("resource_path", &Settings::resourcePath)
-        .def_readwrite("simulation_speed", &Settings::simulationSpeed);
+        .def_readwrite("simulation_speed", &Settings::simulationSpeed)
+        .def_readwrite("headless", &Settings::headless)
+        .def_readwrite("fast_forward", &Settings::fastForward)
+        .def_readwrite("lockstep", &Settings::lockstep)
+        .def_readwrite("lockstep_timeout", &Settings::lockstepTimeout)
+        .def_readwrite("threaded_simulation", &Settings::threadedSimulation)
+        .def_readwrite("shared_memory_instance", &Settings::sharedMemoryInstance)
+        .def_readwrite("posix_shared_memory", &Settings::posixSharedMemory)
+        .def_readwrite("huge_pages", &Settings::hugePages)
+        .def_readwrite("capture_depth", &Settings::captureDepth)
+        .def_readwrite("profile_path", &Settings::profilePath);
 
     pybind11::class_<Loop>(m, "Loop")
         .def(pybind11::init<Settings>(), pybind11::arg("settings") = Settings())
         .def("loop", &Loop::loop)
         .def("step", &Loop::step)
+        .def_readonly("model_store", &Loop::modelStore)
         .def("get_previous_frame",
             [](Loop& loop, Scene& scene) {
 
@@ -41,9 +54,17 @@ PYBIND11_MODULE(pyspatzsim, m) {
 
                 pybind11::array_t<unsigned char> frame(dims, nullptr);
 
+                // the color image is only rendered once python consumes
+                // it, so for the first frame it has to be rendered here
+
+                if (!loop.pythonMainCameraConsumer) {
+                    loop.pythonMainCameraConsumer = true;
+                    loop.renderCarColorView(scene, loop.renderState);
+                }
+
                 glBindFramebuffer(GL_FRAMEBUFFER, loop.car.frameBuffer.id);
 
-                loop.pythonMainCameraCapture.capture(
+                bool captured = loop.pythonMainCameraCapture.capture(
                         frame.mutable_data(), 
                         scene.car.mainCamera.imageWidth,
                         scene.car.mainCamera.imageHeight,
@@ -53,6 +74,10 @@ PYBIND11_MODULE(pyspatzsim, m) {
 
                 glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+                if (!captured) {
+                    throw std::runtime_error("Could not read the main camera frame.");
+                }
+
                 // Because the images are downloaded inverted into memory
                 // the resulting numpy array must be flipped.
                 // Which is done here by calling the flip numpy function.
@@ -63,6 +88,21 @@ PYBIND11_MODULE(pyspatzsim, m) {
             }
         );
 
+    pybind11::class_<ModelStore>(m, "ModelStore");
+
+    pybind11::class_<BatchSimulator>(m, "BatchSimulator")
+        .def(pybind11::init<ModelStore&, size_t, float>(),
+            pybind11::arg("model_store"),
+            pybind11::arg("thread_count") = std::thread::hardware_concurrency(),
+            pybind11::arg("update_delta_time") = 0.005f,
+            pybind11::keep_alive<1, 2>())
+        .def("add", &BatchSimulator::add)
+        .def("__len__", &BatchSimulator::size)
+        .def("get_scene", &BatchSimulator::getScene,
+            pybind11::return_value_policy::reference_internal)
+        .def("step", &BatchSimulator::step,
+            pybind11::call_guard<pybind11::gil_scoped_release>());
+
     pybind11::class_<Scene>(m, "Scene")
         .def(pybind11::init())
         .def(pybind11::init<std::string>())
@@ -210,9 +250,15 @@ PYBIND11_MODULE(pyspatzsim, m) {
         .def_readwrite("pose", &Car::MainCamera::pose)
         .def_readwrite("fov", &Car::MainCamera::fovy)
         .def_readwrite("noise", &Car::MainCamera::noise)
+        .def_readwrite("timing", &Car::MainCamera::timing)
         .def_readwrite("image_width", &Car::MainCamera::imageWidth)
         .def_readwrite("image_height", &Car::MainCamera::imageHeight);
 
+    pybind11::class_<Car::SensorTiming>(m, "SensorTiming")
+        .def(pybind11::init())
+        .def_readwrite("rate", &Car::SensorTiming::rate)
+        .def_readwrite("phase", &Car::SensorTiming::phase);
+
     pybind11::class_<Car::Vesc>(m, "Vesc")
         .def(pybind11::init())
         .def_readwrite("velocity", &Car::Vesc::velocity)
@@ -2,15 +2,25 @@
 
 uniform bool lighting = true;
 
-uniform vec3 lightPosition;
-uniform vec3 ia;
-uniform vec3 id;
-uniform vec3 is;
-
-uniform vec3 ka;
-uniform vec3 kd;
-uniform vec3 ks;
-uniform float ns;
+/*
+ * See PointLight::UniformBlock.
+ */
+layout(std140) uniform Light {
+    vec3 lightPosition;
+    vec3 ia;
+    vec3 id;
+    vec3 is;
+};
+
+/*
+ * Every model has its own material buffer, see Model.
+ */
+layout(std140) uniform Material {
+    vec3 ka;
+    vec3 kd;
+    vec3 ks;
+    float ns;
+};
 
 uniform float time;
 
@@ -1,16 +1,30 @@
 #version 330
 
 uniform mat4 model; 
-uniform mat4 view;
 uniform mat3 normalMat;
-uniform mat4 projection;
-uniform vec3 cameraPosition;
+
+/*
+ * Written once per view, see Camera::UniformBlock.
+ */
+layout(std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPosition;
+};
 
 uniform bool billboard = false;
 
+/*
+ * Instanced models take the model and normal matrix
+ * from the instance attributes instead of the uniforms.
+ */
+uniform bool instanced = false;
+
 layout(location = 0) in vec3 vertex;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 textureCoord;
+layout(location = 3) in mat4 instanceModel;
+layout(location = 7) in mat3 instanceNormalMat;
 
 out vec4 fragPosition;
 out vec4 fragViewPosition;
@@ -23,6 +37,14 @@ void main () {
     fragTextureCoord = textureCoord;
     fragCameraPosition = cameraPosition;
 
+    mat4 modelMat = model;
+    mat3 normalMatrix = normalMat;
+
+    if (instanced) {
+        modelMat = instanceModel;
+        normalMatrix = instanceNormalMat;
+    }
+
     if (billboard) {
         /*
          * This transforms each vertex along the coordinate axis 
@@ -37,9 +59,9 @@ void main () {
         vec3 up = vec3(view[0][1], view[1][1], view[2][1]);
         vec3 eye = vec3(view[0][2], view[1][2], view[2][2]);
 
-        vec3 center = vec3(model * vec4(0, 0, 0, 1));
+        vec3 center = vec3(modelMat * vec4(0, 0, 0, 1));
         mat4 rotScaleModelMat = mat4(
-            model[0].xyz, 0, model[1].xyz, 0, model[2].xyz, 0, vec3(0, 0, 0), 1);
+            modelMat[0].xyz, 0, modelMat[1].xyz, 0, modelMat[2].xyz, 0, vec3(0, 0, 0), 1);
         vec3 modVertex = vec3(rotScaleModelMat * vec4(vertex, 1));
 
         fragNormal = normalize(vec3(right * normal.x + up * normal.y + eye * normal.z));
@@ -49,8 +71,8 @@ void main () {
             + up * modVertex.y
             + eye * modVertex.z, 1.0);
     } else {
-        fragNormal = normalize(normalMat * normal);
-        fragPosition = model * vec4(vertex, 1);
+        fragNormal = normalize(normalMatrix * normal);
+        fragPosition = modelMat * vec4(vertex, 1);
     }
 
     fragViewPosition = view * fragPosition;
@@ -0,0 +1,69 @@
+#include "BatchSimulator.h"
+
+BatchSimulator::Instance::Instance(Scene scene) : scene{scene} {
+
+    // the copied scene still shares the tracks with the original,
+    // which are changed by the autotracks of this instance, and
+    // the selection points into the items of the original
+
+    this->scene.tracks = scene.tracks.clone();
+    this->scene.selection.pose = nullptr;
+}
+
+BatchSimulator::BatchSimulator(
+        ModelStore& modelStore,
+        size_t threadCount,
+        float updateDeltaTime)
+    : modelStore{modelStore}
+    , threadPool{threadCount}
+    , updateDeltaTime{updateDeltaTime} {
+}
+
+size_t BatchSimulator::add(Scene scene) {
+
+    instances.push_back(std::make_unique<Instance>(scene));
+
+    return instances.size() - 1;
+}
+
+size_t BatchSimulator::size() {
+
+    return instances.size();
+}
+
+Scene& BatchSimulator::getScene(size_t index) {
+
+    return instances.at(index)->scene;
+}
+
+void BatchSimulator::step(size_t ticks) {
+
+    threadPool.run(instances.size(), [&](size_t i) {
+        for (size_t t = 0; t < ticks; t++) {
+            tick(*instances[i]);
+        }
+    });
+}
+
+void BatchSimulator::tick(Instance& instance) {
+
+    Scene& scene = instance.scene;
+
+    // there is no display in here, both clocks run in simulation time
+
+    scene.simulationClock.windup(updateDeltaTime);
+    scene.simulationClock.step(updateDeltaTime);
+
+    scene.displayClock.windup(updateDeltaTime);
+    scene.displayClock.step(updateDeltaTime);
+
+    if (scene.enableAutoTracks) {
+        instance.simulation.autoTracks.update(scene);
+    }
+
+    if (scene.failTime == 0) {
+        instance.simulation.update(scene, modelStore, updateDeltaTime);
+    }
+
+    instance.simulation.updateRules(scene);
+}
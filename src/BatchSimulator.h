@@ -0,0 +1,66 @@
+#ifndef INC_2019_BATCHSIMULATOR_H
+#define INC_2019_BATCHSIMULATOR_H
+
+#include <memory>
+#include <vector>
+
+#include "helpers/Helpers.h"
+#include "scene/Scene.h"
+#include "scene/ModelStore.h"
+#include "Simulation.h"
+
+/*
+ * Simulates many independent scenes in parallel, e.g. for closed loop
+ * rollouts in a parameter search. Only physics, collisions, dynamic
+ * items, laser sensors and rules are simulated, nothing is rendered
+ * or transmitted. Between the calls of step() the scenes can be read
+ * and the vesc commands of the cars can be set.
+ *
+ * All instances share one ModelStore, which has to be loaded with
+ * an OpenGL context (e.g. the one of a Loop), but is only read here.
+ */
+class BatchSimulator {
+
+    struct Instance {
+
+        Scene scene;
+        Simulation simulation;
+
+        explicit Instance(Scene scene);
+    };
+
+    ModelStore& modelStore;
+    ThreadPool threadPool;
+
+    std::vector<std::unique_ptr<Instance>> instances;
+
+    void tick(Instance& instance);
+
+public:
+
+    /*
+     * The simulation time step of every tick.
+     */
+    float updateDeltaTime;
+
+    BatchSimulator(
+            ModelStore& modelStore,
+            size_t threadCount = std::thread::hardware_concurrency(),
+            float updateDeltaTime = 0.005f);
+
+    /*
+     * Adds a copy of the scene (with its own tracks) and returns its index.
+     */
+    size_t add(Scene scene);
+
+    size_t size();
+
+    Scene& getScene(size_t index);
+
+    /*
+     * Runs the given number of ticks on all scenes, in parallel.
+     */
+    void step(size_t ticks);
+};
+
+#endif
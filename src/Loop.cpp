@@ -1,32 +1,59 @@
 #include "Loop.h"
 
+#include "Storage.h"
+
+// set by SIGINT and SIGTERM, so that the loop returns and the
+// destructors remove the shared memory and finish the recording
+
+static std::atomic<bool> stopRequested{false};
+
+static void requestStop(int) {
+    stopRequested = true;
+}
+
 GLFWwindow* setupGlfw(Settings& settings) {
 
-    if (!glfwInit()) {
-        std::cout << "Could not initialize GLFW!" << std::endl;
-        std::exit(-1);
-    }
+    GLFWwindow* window = nullptr;
 
-    glfwWindowHint(GLFW_SAMPLES, settings.msaaSamplesEditorView);
+    if (!settings.headless) {
 
-    GLFWwindow* window = glfwCreateWindow(
-            settings.windowWidth,
-            settings.windowHeight,
-            "SpatzSim",
-            nullptr,
-            nullptr);
+        if (!glfwInit()) {
+            std::cout << "Could not initialize GLFW!" << std::endl;
+            std::exit(-1);
+        }
 
-    if (settings.fullscreen) {
-        GLFWmonitor* monitor = glfwGetPrimaryMonitor();
-        const GLFWvidmode* mode = glfwGetVideoMode(monitor);
-        glfwSetWindowMonitor(window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
-    }
+        glfwWindowHint(GLFW_SAMPLES, settings.msaaSamplesEditorView);
+
+        window = glfwCreateWindow(
+                settings.windowWidth,
+                settings.windowHeight,
+                "SpatzSim",
+                nullptr,
+                nullptr);
 
-    glfwMakeContextCurrent(window);
+        if (settings.fullscreen) {
+            GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+            const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+            glfwSetWindowMonitor(window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
+        }
+
+        glfwMakeContextCurrent(window);
+    }
 
     glewExperimental = true;
 
-    if (GLEW_OK != glewInit()) {
+    GLenum glewStatus = glewInit();
+
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW (built for GLX) complains if there is no X display,
+    // which is always the case for the EGL context in headless mode.
+    // The core and extension functions are loaded anyway.
+    if (settings.headless && GLEW_ERROR_NO_GLX_DISPLAY == glewStatus) {
+        glewStatus = GLEW_OK;
+    }
+#endif
+
+    if (GLEW_OK != glewStatus) {
         std::cout << "GL Extension Wrangler initialization failed!" << std::endl;
         std::exit(-1);
     }
@@ -35,7 +62,8 @@ GLFWwindow* setupGlfw(Settings& settings) {
 }
 
 Loop::Loop(Settings settings)
-    : window{setupGlfw(settings)}
+    : headlessContext{settings.headless}
+    , window{setupGlfw(settings)}
     , settings{settings}
     , screenFrameBuffer{settings.windowWidth, settings.windowHeight}
     , frameBuffer{
@@ -57,21 +85,59 @@ Loop::Loop(Settings settings)
         settings.resourcePath + "shaders/BayerVertexShader.glsl", 
         settings.resourcePath + "shaders/DepthPointsFragmentShader.glsl"}
     , modelStore{settings.resourcePath}
+    , commModule{
+        settings.sharedMemoryInstance,
+        settings.posixSharedMemory
+            ? SimulatorSHM::BACKEND_POSIX
+            : SimulatorSHM::BACKEND_SYSV,
+        settings.hugePages}
     , guiModule{window, settings.configPath} {
 
     glClearColor(1.0, 1.0, 1.0, 1.0);
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
 
-    glfwSwapInterval(0);
+    // python reads one frame per call and expects the current one
+
+    pythonMainCameraCapture.synchronous = true;
 
-    initInput(window);
+    // in lockstep mode ticks are paced by the controller, not the wall
+    // clock and camera images must belong to the tick they are sent with
+
+    if (settings.lockstep) {
+        this->settings.fastForward = true;
+        mainCameraCapture.synchronous = true;
+        depthCameraCapture.synchronous = true;
+    }
+
+    // in fast forward mode the camera images are rendered in between
+    // the ticks, which requires the ticks to run on the GL thread
+
+    if (this->settings.threadedSimulation && this->settings.fastForward) {
+        std::cout << "The threaded simulation is not available in "
+                  << "fast forward or lockstep mode." << std::endl;
+        this->settings.threadedSimulation = false;
+    }
+
+    if (!settings.recordPath.empty()) {
+        commModule.startRecording(settings.recordPath);
+    }
+
+    profiler.enabled = !settings.profilePath.empty();
+
+    if (!settings.headless) {
+        glfwSwapInterval(0);
+
+        initInput(window);
+    }
 }
 
 Loop::~Loop() {
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (!settings.headless) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
 
 void renderToScreen (
@@ -124,16 +190,27 @@ void renderToScreen (
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, dstFrameBuffer.colorTextureId);
-    glUniform1i(glGetUniformLocation(shaderProgramId, "tex"), 0);
+    glUniform1i(ShaderProgram::getUniforms(shaderProgramId).tex, 0);
 
     screenQuad.end();
 }
 
 void Loop::loop(Scene& scene) {
 
+    if (settings.threadedSimulation) {
+        simulationRunning = true;
+        simulationThread = std::thread(&Loop::simulate, this, std::ref(scene));
+    }
+
+    stopRequested = false;
+
+    auto previousSigintHandler = std::signal(SIGINT, requestStop);
+    auto previousSigtermHandler = std::signal(SIGTERM, requestStop);
+
     auto time = std::chrono::steady_clock::now();
 
-    while (!glfwWindowShouldClose(window)) {
+    while (!stopRequested
+            && (settings.headless || !glfwWindowShouldClose(window))) {
 
         auto now = std::chrono::steady_clock::now();
 
@@ -143,27 +220,151 @@ void Loop::loop(Scene& scene) {
         time = now;
 
         step(scene, frameDeltaTime);
+
+        // without a window there is nothing to show between
+        // the ticks and camera images, thus wait for the next
+
+        if (settings.headless) {
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                        (long)(getIdleTime(scene) * 1000000.0f)));
+        }
+    }
+
+    if (simulationThread.joinable()) {
+        simulationRunning = false;
+        simulationThread.join();
+    }
+
+    std::signal(SIGINT, previousSigintHandler);
+    std::signal(SIGTERM, previousSigtermHandler);
+
+    if (!settings.profilePath.empty()) {
+        const std::string& path = settings.profilePath;
+
+        bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+        if (!(json
+                    ? storage::save(profiler, path)
+                    : storage::saveCsv(profiler, path))) {
+            std::cerr << "Could not write the profile to " << path << "." << std::endl;
+        }
+    }
+}
+
+float Loop::getIdleTime(Scene& scene) {
+
+    // in fast forward mode the ticks run back to back
+
+    if (settings.fastForward && !scene.paused) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> sceneLock(sceneMutex);
+
+    if (scene.paused || settings.simulationSpeed <= 0) {
+        return settings.updateDeltaTime;
+    }
+
+    // the rendered time follows the accumulator, thus the next camera
+    // image is due once it has grown by the gap to the sensor period
+
+    double time = renderState.time;
+
+    double idleTime = std::min({
+            (double)(settings.updateDeltaTime - scene.simulationClock.accumulator),
+            getNextSensorTime(scene.car.mainCamera.timing, time) - time,
+            getNextSensorTime(scene.car.depthCamera.timing, time) - time});
+
+    return (float)std::max(idleTime, 0.0) / settings.simulationSpeed;
+}
+
+void Loop::simulate(Scene& scene) {
+
+    // The simulation clock is wound up by the wall clock just like
+    // in step. The scene lock is released after every tick, thus the
+    // render thread has to wait for one tick at most.
+
+    auto time = std::chrono::steady_clock::now();
+
+    while (simulationRunning) {
+
+        auto now = std::chrono::steady_clock::now();
+
+        float deltaTime = 
+            (float)std::chrono::duration_cast<std::chrono::microseconds>(
+                    now - time).count() / 1000000.0f;
+        time = now;
+
+        std::unique_lock<std::mutex> sceneLock(sceneMutex);
+
+        if (!scene.paused) {
+            scene.simulationClock.windup(deltaTime * settings.simulationSpeed);
+        }
+
+        while (scene.simulationClock.step(settings.updateDeltaTime)) {
+
+            tick(scene);
+
+            RenderSnapshot& snapshot = renderSnapshots.getWriteBuffer();
+            snapshot.previous = previousRenderState;
+            snapshot.current = currentRenderState;
+            renderSnapshots.publish();
+
+            sceneLock.unlock();
+            sceneLock.lock();
+        }
+
+        // sleep until the next tick is due
+
+        float sleepTime = settings.updateDeltaTime;
+
+        if (!scene.paused && settings.simulationSpeed > 0) {
+            sleepTime = (settings.updateDeltaTime
+                    - scene.simulationClock.accumulator)
+                / settings.simulationSpeed;
+        }
+
+        sceneLock.unlock();
+
+        std::this_thread::sleep_for(
+                std::chrono::microseconds((long)(sleepTime * 1000000.0f)));
     }
 }
 
 void Loop::step(Scene& scene, float frameDeltaTime) {
 
+    // in threaded mode the simulation thread winds up the
+    // simulation clock and runs the ticks, see simulate
+
+    bool threaded = simulationThread.joinable();
+
+    // the scene is locked while the input and the editor change it and
+    // the render state is taken from it. The views are rendered from
+    // the render state only, without holding the lock.
+
+    std::unique_lock<std::mutex> sceneLock(sceneMutex);
+
+    Profiler::Scope inputScope(profiler, INPUT_PHASE);
+
     scene.displayClock.windup(frameDeltaTime); 
-    if (!scene.paused) {
+    if (!scene.paused && !threaded) {
         scene.simulationClock.windup(frameDeltaTime * settings.simulationSpeed); 
     }
 
-    updateInput();
+    if (!settings.headless) {
+
+        updateInput();
 
-    // TODO: make this less hacky, this is not right here
+        // TODO: make this less hacky, this is not right here
 
-    for (MouseButtonEvent& evt : getMouseButtonEvents()) {
-        if (evt.action == GLFW_PRESS && evt.button == GLFW_MOUSE_BUTTON_LEFT) {
-            scene.selection.handled = false;
+        for (MouseButtonEvent& evt : getMouseButtonEvents()) {
+            if (evt.action == GLFW_PRESS && evt.button == GLFW_MOUSE_BUTTON_LEFT) {
+                scene.selection.handled = false;
+            }
         }
-    }
 
-    guiModule.begin();
+        guiModule.begin();
+    }
 
     // gui updates 
 
@@ -171,6 +372,10 @@ void Loop::step(Scene& scene, float frameDeltaTime) {
 
         commModule.receiveVisualization(scene.visualization);
 
+        if (settings.headless) {
+            continue;
+        }
+
         if (FPS_CAMERA == selectedCamera) {
             scene.fpsCamera.update(window, settings.updateDeltaTime);
         } else if (FOLLOW_CAMERA == selectedCamera) {
@@ -212,129 +417,344 @@ void Loop::step(Scene& scene, float frameDeltaTime) {
             break;
     }
 
-    if (FPS_CAMERA == selectedCamera) {
+    if (FPS_CAMERA == selectedCamera && !settings.headless) {
         if (settings.showMarkers) {
             markerModule.update(window, scene.fpsCamera, scene.selection);
             editor.updateInput(scene.fpsCamera, scene.tracks, scene.groundSize);
         }
 
-        itemsModule.update(scene.items, scene.selection.pose);
+        simulation.itemsModule.update(scene.items, scene.selection.pose);
     }
 
+    inputScope.stop();
+
     // actual simulation updates
-    
-    while (scene.simulationClock.step(settings.updateDeltaTime)) {
 
-        if (scene.enableAutoTracks) {
-            autoTracks.update(scene);
+    Profiler::Scope simulationScope(profiler, SIMULATION_PHASE);
+
+    if (threaded) {
+        // the ticks run on the simulation thread
+    } else if (settings.fastForward) {
+        fastForward(scene);
+    } else {
+        while (scene.simulationClock.step(settings.updateDeltaTime)) {
+            tick(scene);
         }
+    }
+
+    simulationScope.stop();
+
+    // start rendering camera images
+
+    scene.addToHistory();
+
+    RenderState* previous = &previousRenderState;
+    RenderState* current = &currentRenderState;
+
+    if (threaded) {
+        renderSnapshots.update();
+        previous = &renderSnapshots.getReadBuffer().previous;
+        current = &renderSnapshots.getReadBuffer().current;
+    }
+
+    // the scene was changed without a simulation tick (paused, edited
+    // or a new scene was loaded), thus there is nothing to interpolate
+
+    if (scene.paused || current->time != scene.simulationClock.time) {
+        current->capture(scene);
+        *previous = *current;
+    }
 
-        // TODO: Doing receive in such a way is not really correct!
-        // Likely the vesc value will not actually change n-times
-        // during the iteration. Probably, we will read the same
-        // value n-times. We need to make sure that the buffer
-        // queue in the shared memory is actually used.
+    // interpolate between the last two ticks by the time left in the
+    // accumulator, this gives a smooth result even though the frame
+    // time is no multiple of the simulation time step.
+    // in fast forward mode the accumulator is not used.
 
-        commModule.receiveVesc(scene.car.vesc);
+    float interpolationFactor = 1.0f;
 
-        if (scene.failTime == 0 || !settings.instantCloseInAutotrack) {
-            update(scene, settings.updateDeltaTime);
-        } else if (scene.displayClock.time - scene.failTime > 5.0) {
-            exit(-1);
+    if (!settings.fastForward) {
+        interpolationFactor =
+            scene.simulationClock.accumulator / settings.updateDeltaTime;
+    }
+
+    renderState.interpolate(*previous, *current, interpolationFactor);
+
+    editor.captureTrackModels(scene.tracks, renderState.trackModels);
+
+    car.updateMainCamera(scene.car.mainCamera, renderState.carModelPose);
+    car.updateDepthCamera(scene.car.depthCamera, renderState.carModelPose);
+
+    if (!settings.headless) {
+        if (FPS_CAMERA == selectedCamera) {
+            scene.fpsCamera.update(window, scene.displayClock.accumulator);
+        } else if (FOLLOW_CAMERA == selectedCamera) {
+            scene.followCamera.update(renderState.carModelPose);
+        } else if (CINEMATIC_CAMERA == selectedCamera) {
+            scene.cinematicCamera.update(renderState.carModelPose);
         }
+    }
 
-        bool noViolation = ruleModule.update(
-                scene.displayClock.time,
-                scene.simulationClock.time,
-                scene.rules,
-                scene.car,
-                scene.tracks,
-                scene.items,
-                collisionModule);
+    // in fast forward mode the camera images are rendered between
+    // the ticks. While paused they are rendered every frame (in fast
+    // forward mode as well, as no ticks are run then), so that changes
+    // in the editor are visible in the camera views.
+
+    bool mainCameraDue = scene.paused || (!settings.fastForward
+            && isSensorDue(lastMainCameraFrame,
+                scene.car.mainCamera.timing, renderState.time));
+
+    bool depthCameraDue = scene.paused || (!settings.fastForward
+            && isSensorDue(lastDepthCameraFrame,
+                scene.car.depthCamera.timing, renderState.time));
+
+    float mainCameraAspectRatio = scene.car.mainCamera.getAspectRatio();
+    float depthCameraAspectRatio = scene.car.depthCamera.getDepthAspectRatio();
+
+    sceneLock.unlock();
 
-        if (scene.failTime != 0 && scene.enableAutoTracks && noViolation) {
-            scene.failTime = 0;
+    if (mainCameraDue) {
+        renderCarView(scene, renderState);
+
+        if (isMainCameraColorConsumed()) {
+            renderCarColorView(scene, renderState);
         }
+    }
 
-        if (scene.failTime == 0 && scene.enableAutoTracks && !noViolation) {
-            scene.failTime = scene.displayClock.time;
+    if (depthCameraDue) {
+        renderDepthView(scene, renderState);
+    }
 
-            ruleModule.printViolation(
-                    scene.simulationClock.time,
-                    scene.car.drivenDistance);
+    if (!settings.headless) {
+
+        renderFpsView(scene, renderState);
+
+        // the markers and the gui show and change the live scene
+
+        sceneLock.lock();
+        renderFpsOverlay(scene);
+        sceneLock.unlock();
+
+        // render on screen filling quad
+
+        Profiler::Scope screenScope(profiler, SCREEN_PHASE);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+        if (MAIN_CAMERA == selectedCamera) {
+            renderToScreen(
+                    settings.windowWidth, 
+                    settings.windowHeight, 
+                    screenQuad, 
+                    mainCameraAspectRatio, 
+                    true, 
+                    car.frameBuffer,
+                    screenFrameBuffer);
+        } else if (DEPTH_CAMERA == selectedCamera) {
+            renderToScreen(
+                    settings.windowWidth, 
+                    settings.windowHeight, 
+                    screenQuad, 
+                    depthCameraAspectRatio, 
+                    true, 
+                    car.depthCameraFrameBuffer,
+                    screenFrameBuffer);
+        } else { // FPS_CAMERA or FOLLOW_CAMERA or CINEMATIC_CAMERA
+            renderToScreen(
+                    settings.windowWidth, 
+                    settings.windowHeight, 
+                    screenQuad, 
+                    1, 
+                    false, 
+                    frameBuffer,
+                    screenFrameBuffer);
         }
 
-        commModule.transmitCar(
+        screenScope.stop();
+
+        sceneLock.lock();
+        renderGui(scene);
+        sceneLock.unlock();
+    }
+
+    // synchronous captures and swapping may stall on the gpu, the
+    // simulation thread must not wait for that. The transmit
+    // functions only read the camera sizes, which are never
+    // changed by the simulation thread.
+
+    Profiler::Scope captureScope(profiler, CAPTURE_PHASE);
+
+    if (mainCameraDue) {
+        commModule.transmitMainCamera(
                 scene.car, 
-                scene.paused, 
-                scene.simulationClock.time);
+                mainCameraCapture, 
+                car.bayerFrameBuffer.id,
+                renderState.tick,
+                renderState.time,
+                car.mainCamera.pose);
     }
 
-    // start rendering camera images
+    if (depthCameraDue) {
+        commModule.transmitDepthCamera(
+                scene.car, 
+                depthCameraCapture, 
+                car.depthCameraFrameBuffer.id,
+                renderState.tick,
+                renderState.time,
+                car.depthCamera.pose);
+    }
 
-    scene.addToHistory();
+    // the images are sent once their transfer is complete,
+    // usually a frame or two after they were rendered
 
-    // copy scene then update by the amount of time in the accumulator.
-    // this will give a very smooth rendering result even though the
-    // actual values in the scene are likely not correct due to floating
-    // point errors and because the accumulator might be small.
-    // this is why the scene is copied here and restored at mark (1)
-    
-    Scene preRenderScene = scene;
+    commModule.transmitCompletedImages(mainCameraCapture, depthCameraCapture);
 
+    captureScope.stop();
 
-    if (scene.failTime == 0) {
-        update(scene, scene.simulationClock.accumulator);
+    if (!settings.headless) {
+        Profiler::Scope swapScope(profiler, SWAP_PHASE);
+        glfwSwapBuffers(window);
     }
 
-    if (FPS_CAMERA == selectedCamera) {
-        scene.fpsCamera.update(window, scene.displayClock.accumulator);
-    } else if (FOLLOW_CAMERA == selectedCamera) {
-        scene.followCamera.update(scene.car.modelPose);
-    } else if (CINEMATIC_CAMERA == selectedCamera) {
-        scene.cinematicCamera.update(scene.car.modelPose);
+    profiler.endFrame();
+}
+
+void Loop::tick(Scene& scene) {
+
+    if (scene.enableAutoTracks) {
+        Profiler::Scope autoTracksScope(profiler, AUTOTRACKS_PHASE);
+        simulation.autoTracks.update(scene);
+    }
+
+    // The vesc commands are queued and each one is applied in the
+    // tick that reaches the time it was stamped with by the controller.
+    // In lockstep mode the tick waits for the command that
+    // acknowledges the previously transmitted car state instead.
+
+    if (settings.lockstep) {
+        if (!commModule.receiveVescLockstep(
+                    scene.car.vesc, settings.lockstepTimeout)) {
+            std::cout << "Lockstep: no vesc command received within "
+                      << settings.lockstepTimeout
+                      << " seconds, keeping the last command."
+                      << std::endl;
+        }
+    } else {
+        commModule.receiveVesc(scene.car.vesc, scene.simulationClock.time);
+    }
+
+    if (scene.failTime == 0 || !settings.instantCloseInAutotrack) {
+        update(scene, settings.updateDeltaTime);
+    } else if (scene.displayClock.time - scene.failTime > 5.0) {
+        exit(-1);
     }
 
-    renderCarView(scene);
-    renderDepthView(scene);
-    renderFpsView(scene);
+    Profiler::Scope rulesScope(profiler, RULES_PHASE);
 
-    // render on screen filling quad
+    simulation.updateRules(scene);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    rulesScope.stop();
 
-    if (MAIN_CAMERA == selectedCamera) {
-        renderToScreen(
-                settings.windowWidth, 
-                settings.windowHeight, 
-                screenQuad, 
-                scene.car.mainCamera.getAspectRatio(), 
-                true, 
-                car.frameBuffer,
-                screenFrameBuffer);
-    } else if (DEPTH_CAMERA == selectedCamera) {
-        renderToScreen(
-                settings.windowWidth, 
-                settings.windowHeight, 
-                screenQuad, 
-                scene.car.depthCamera.getDepthAspectRatio(), 
-                true, 
-                car.depthCameraFrameBuffer,
-                screenFrameBuffer);
-    } else { // FPS_CAMERA or FOLLOW_CAMERA or CINEMATIC_CAMERA
-        renderToScreen(
-                settings.windowWidth, 
-                settings.windowHeight, 
-                screenQuad, 
-                1, 
-                false, 
-                frameBuffer,
-                screenFrameBuffer);
-    }
-
-    // mark (1): restore scene saved before the rendering
-
-    scene = preRenderScene;
+    std::swap(previousRenderState, currentRenderState);
+    currentRenderState.capture(scene);
+
+    // camera images are transmitted before the car state, so that
+    // in lockstep mode they are available once the state is read
+
+    if (settings.fastForward) {
+        renderDueSensors(scene);
+    }
+
+    commModule.transmitCar(
+            scene.car, 
+            scene.paused, 
+            scene.simulationClock.time,
+            scene.simulationClock.ticks);
+}
+
+void Loop::fastForward(Scene& scene) {
+
+    // In fast forward mode the simulation clock is not wound up by
+    // the wall clock. Instead, simulation ticks are run back to back
+    // until the wall clock time of one displayed frame is used up.
+    // The camera images are rendered in between the ticks (see tick),
+    // but only when the camera is due according to its timing.
+
+    auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::microseconds((long)(fastForwardFrameTime * 1000000.0f));
+
+    scene.simulationClock.accumulator = 0;
+
+    while (!scene.paused && std::chrono::steady_clock::now() < deadline) {
+
+        scene.simulationClock.windup(settings.updateDeltaTime);
+        scene.simulationClock.step(settings.updateDeltaTime);
+
+        tick(scene);
+    }
+}
+
+void Loop::renderDueSensors(Scene& scene) {
+
+    car.updateMainCamera(scene.car.mainCamera, scene.car.modelPose);
+    car.updateDepthCamera(scene.car.depthCamera, scene.car.modelPose);
+
+    bool mainCameraDue = isSensorDue(
+            lastMainCameraFrame,
+            scene.car.mainCamera.timing,
+            scene.simulationClock.time);
+
+    bool depthCameraDue = isSensorDue(
+            lastDepthCameraFrame,
+            scene.car.depthCamera.timing,
+            scene.simulationClock.time);
+
+    // the ticks run on this thread, thus the tracks can be taken
+    // from the scene directly, but only if there is anything to render
+
+    if (mainCameraDue || depthCameraDue) {
+        editor.captureTrackModels(scene.tracks, currentRenderState.trackModels);
+    }
+
+    if (mainCameraDue) {
+
+        renderCarView(scene, currentRenderState);
+
+        if (isMainCameraColorConsumed()) {
+            renderCarColorView(scene, currentRenderState);
+        }
+
+        Profiler::Scope captureScope(profiler, CAPTURE_PHASE);
+
+        commModule.transmitMainCamera(
+                scene.car, 
+                mainCameraCapture, 
+                car.bayerFrameBuffer.id,
+                scene.simulationClock.ticks,
+                scene.simulationClock.time,
+                car.mainCamera.pose);
+    }
+
+    if (depthCameraDue) {
+
+        renderDepthView(scene, currentRenderState);
+
+        Profiler::Scope captureScope(profiler, CAPTURE_PHASE);
+
+        commModule.transmitDepthCamera(
+                scene.car, 
+                depthCameraCapture, 
+                car.depthCameraFrameBuffer.id,
+                scene.simulationClock.ticks,
+                scene.simulationClock.time,
+                car.depthCamera.pose);
+    }
+
+    commModule.transmitCompletedImages(mainCameraCapture, depthCameraCapture);
+}
+
+void Loop::renderGui(Scene& scene) {
+
+    Profiler::Scope guiScope(profiler, GUI_PHASE);
 
     if (guiModule.renderSettingsWindow(settings)) {
         glfwSetWindowSize(
@@ -363,75 +783,54 @@ void Loop::step(Scene& scene, float frameDeltaTime) {
     guiModule.renderSceneWindow(scene);
     guiModule.renderRuleWindow(scene.rules);
     guiModule.renderHelpWindow();
+    guiModule.renderProfilerWindow(profiler, !settings.profilePath.empty());
+    guiModule.renderLatencyWindow(commModule.latencies);
     guiModule.renderAboutWindow();
 
     guiModule.end();
-
-    commModule.transmitMainCamera(
-            scene.car, 
-            mainCameraCapture, 
-            car.bayerFrameBuffer.id);
-
-    commModule.transmitDepthCamera(
-            scene.car, 
-            depthCameraCapture, 
-            car.depthCameraFrameBuffer.id);
-
-    glfwSwapBuffers(window);
 }
 
 void Loop::update(Scene& scene, float deltaTime) {
 
-    collisionModule.add(scene.car.modelPose, modelStore.car);
+    Profiler::Scope collisionScope(profiler, COLLISION_PHASE);
 
-    for (auto& i : scene.items) {
-        if (i.type == OBSTACLE) {
-            collisionModule.add(i.pose, modelStore.items[OBSTACLE]);
-        } else if (i.type == DYNAMIC_OBSTACLE) {
-            collisionModule.add(i.pose, modelStore.items[DYNAMIC_OBSTACLE]);
-        } else if (i.type == PEDESTRIAN) {
-            collisionModule.add(i.pose, modelStore.items[PEDESTRIAN]);
+    simulation.updateCollisions(scene, modelStore);
 
-        } else if (i.type == DYNAMIC_PEDESTRIAN_RIGHT) {
-            collisionModule.add(i.pose, modelStore.items[PEDESTRIAN]);
-        } else if (i.type == DYNAMIC_PEDESTRIAN_LEFT) {
-            collisionModule.add(i.pose, modelStore.items[PEDESTRIAN]);
-        }
-    }
+    collisionScope.stop();
 
-    collisionModule.update();
+    Profiler::Scope physicsScope(profiler, PHYSICS_PHASE);
+
+    simulation.updatePhysics(scene, deltaTime);
 
     if (!scene.paused) {
-        car.updatePosition(scene.car, deltaTime);
+        car.updateManualControl(scene.car);
     }
 
-    itemsModule.updateDynamicItems(
-            deltaTime,
-            scene.car, 
-            scene.dynamicItemSettings,
-            scene.items);
-
     visModule.addPoseTrace(
             scene.car.modelPose,
             scene.simulationClock.time);
 
-    car.updateMainCamera(scene.car.mainCamera, scene.car.modelPose);
-    car.updateDepthCamera(scene.car.depthCamera, scene.car.modelPose);
-    car.updateLaserSensors(scene.car, modelStore, scene.items);
+    physicsScope.stop();
+
+    Profiler::Scope laserSensorsScope(profiler, LASER_SENSORS_PHASE);
+
+    simulation.updateSensors(scene, modelStore);
 }
 
-void Loop::renderScene(Scene& scene, GLuint shaderProgramId) {
+void Loop::renderScene(RenderState& state, GLuint shaderProgramId) {
 
-    scene.light.render(shaderProgramId);
+    state.light.render(lightUniformBuffer);
 
-    car.render(shaderProgramId, scene.car, modelStore);
+    car.render(shaderProgramId, state.carModelPose, modelStore);
 
-    itemsModule.render(shaderProgramId, modelStore, scene.items);
+    simulation.itemsModule.render(shaderProgramId, modelStore, state);
 
-    editor.renderScene(shaderProgramId, modelStore.rect, scene.tracks, scene.groundSize);
+    editor.renderScene(shaderProgramId, modelStore.rect, state.trackModels, state.groundSize);
 }
 
-void Loop::renderFpsView(Scene& scene) {
+void Loop::renderFpsView(Scene& scene, RenderState& state) {
+
+    Profiler::Scope fpsViewScope(profiler, FPS_VIEW_PHASE);
 
     // make sure that framebuffer is resize properly
     
@@ -444,11 +843,11 @@ void Loop::renderFpsView(Scene& scene) {
 
     glUseProgram(fpsShaderProgram.id);
 
-    GLint timeLocation = glGetUniformLocation(fpsShaderProgram.id, "time");
-    glUniform1f(timeLocation, (float)scene.simulationClock.time * 1000);
+    const ShaderProgram::Uniforms& uniforms =
+        ShaderProgram::getUniforms(fpsShaderProgram.id);
 
-    GLint noiseLocation = glGetUniformLocation(fpsShaderProgram.id, "noise");
-    glUniform1f(noiseLocation, 0.0f);
+    glUniform1f(uniforms.time, (float)state.time * 1000);
+    glUniform1f(uniforms.noise, 0.0f);
 
     glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer.id);
 
@@ -458,16 +857,27 @@ void Loop::renderFpsView(Scene& scene) {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (selectedCamera == FPS_CAMERA) {
-        scene.fpsCamera.render(fpsShaderProgram.id);
+        scene.fpsCamera.render(cameraUniformBuffer);
     } else if (selectedCamera == FOLLOW_CAMERA) {
-        scene.followCamera.render(fpsShaderProgram.id);
+        scene.followCamera.render(cameraUniformBuffer);
     } else if (selectedCamera == CINEMATIC_CAMERA) {
-        scene.cinematicCamera.render(fpsShaderProgram.id);
+        scene.cinematicCamera.render(cameraUniformBuffer);
     } else if (selectedCamera == ORTHO_CAMERA) {
-        scene.orthoCamera.render(fpsShaderProgram.id);
+        scene.orthoCamera.render(cameraUniformBuffer);
     }
 
-    renderScene(scene, fpsShaderProgram.id);
+    renderScene(state, fpsShaderProgram.id);
+}
+
+void Loop::renderFpsOverlay(Scene& scene) {
+
+    Profiler::Scope fpsViewScope(profiler, FPS_VIEW_PHASE);
+
+    glUseProgram(fpsShaderProgram.id);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer.id);
+
+    glViewport(0, 0, settings.windowWidth, settings.windowHeight);
 
     // render markers over everything else
     // thus we clear the depth buffer here
@@ -538,17 +948,17 @@ void Loop::renderFpsView(Scene& scene) {
             scene.visualization, settings);
 }
 
-void Loop::renderCarView(Scene& scene) {
+void Loop::renderCarView(Scene& scene, RenderState& state) {
+
+    Profiler::Scope carViewScope(profiler, CAR_VIEW_PHASE);
 
     glUseProgram(carShaderProgram.id);
 
-    GLint carShaderTimeLocation = 
-        glGetUniformLocation(carShaderProgram.id, "time");
-    glUniform1f(carShaderTimeLocation, (float)scene.simulationClock.time * 1000);
+    const ShaderProgram::Uniforms& uniforms =
+        ShaderProgram::getUniforms(carShaderProgram.id);
 
-    GLint carShaderNoiseLocation = 
-        glGetUniformLocation(carShaderProgram.id, "noise");
-    glUniform1f(carShaderNoiseLocation, scene.car.mainCamera.noise);
+    glUniform1f(uniforms.time, (float)state.time * 1000);
+    glUniform1f(uniforms.noise, scene.car.mainCamera.noise);
 
     glBindFramebuffer(GL_FRAMEBUFFER, car.bayerFrameBuffer.id);
 
@@ -559,19 +969,28 @@ void Loop::renderCarView(Scene& scene) {
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    car.mainCamera.render(carShaderProgram.id);
+    car.mainCamera.render(cameraUniformBuffer);
+
+    renderScene(state, carShaderProgram.id);
+}
 
-    renderScene(scene, carShaderProgram.id);
+bool Loop::isMainCameraColorConsumed() {
 
-    // main camera image in color
+    return (!settings.headless && MAIN_CAMERA == selectedCamera)
+        || pythonMainCameraConsumer;
+}
+
+void Loop::renderCarColorView(Scene& scene, RenderState& state) {
+
+    Profiler::Scope carViewScope(profiler, CAR_VIEW_PHASE);
 
     glUseProgram(fpsShaderProgram.id);
 
-    GLint timeLocation = glGetUniformLocation(fpsShaderProgram.id, "time");
-    glUniform1f(timeLocation, (float)scene.simulationClock.time * 1000);
+    const ShaderProgram::Uniforms& uniforms =
+        ShaderProgram::getUniforms(fpsShaderProgram.id);
 
-    GLint noiseLocation = glGetUniformLocation(fpsShaderProgram.id, "noise");
-    glUniform1f(noiseLocation, scene.car.mainCamera.noise);
+    glUniform1f(uniforms.time, (float)state.time * 1000);
+    glUniform1f(uniforms.noise, scene.car.mainCamera.noise);
 
     glBindFramebuffer(GL_FRAMEBUFFER, car.frameBuffer.id);
 
@@ -582,12 +1001,14 @@ void Loop::renderCarView(Scene& scene) {
     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    car.mainCamera.render(carShaderProgram.id);
+    car.mainCamera.render(cameraUniformBuffer);
 
-    renderScene(scene, carShaderProgram.id);
+    renderScene(state, fpsShaderProgram.id);
 }
 
-void Loop::renderDepthView(Scene& scene) {
+void Loop::renderDepthView(Scene& scene, RenderState& state) {
+
+    Profiler::Scope depthViewScope(profiler, DEPTH_VIEW_PHASE);
 
     glUseProgram(depthCameraShaderProgram.id);
 
@@ -600,9 +1021,9 @@ void Loop::renderDepthView(Scene& scene) {
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    car.depthCamera.render(depthCameraShaderProgram.id);
+    car.depthCamera.render(cameraUniformBuffer);
 
-    renderScene(scene, depthCameraShaderProgram.id);
+    renderScene(state, depthCameraShaderProgram.id);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
@@ -2,9 +2,14 @@
 #define INC_2019_LOOP_H
 
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <deque>
+#include <atomic>
+#include <csignal>
+#include <mutex>
+#include <thread>
 
 #include "helpers/Helpers.h" 
 #include "modules/MarkerModule.h"
@@ -17,11 +22,22 @@
 #include "modules/RuleModule.h"
 #include "modules/VisModule.h"
 #include "modules/AutoTracksModule.h"
+#include "scene/RenderState.h"
+#include "Simulation.h"
 
 class Loop {
 
 public:
 
+    /*
+     * Only holds an actual context in headless mode. It has to be
+     * constructed before anything else that uses OpenGL.
+     */
+    HeadlessContext headlessContext;
+
+    /*
+     * The main window, this is nullptr in headless mode.
+     */
     GLFWwindow* window;
 
     Settings settings;
@@ -34,9 +50,18 @@ public:
     ShaderProgram carShaderProgram;
     ShaderProgram depthCameraShaderProgram;
 
-    Capture pythonMainCameraCapture;
-    Capture mainCameraCapture;
-    Capture depthCameraCapture;
+    /*
+     * Shared by all shader programs, the camera buffer
+     * is written again at the start of every view.
+     */
+    UniformBuffer cameraUniformBuffer{
+        CAMERA_BLOCK_BINDING, sizeof(Camera::UniformBlock)};
+    UniformBuffer lightUniformBuffer{
+        LIGHT_BLOCK_BINDING, sizeof(PointLight::UniformBlock)};
+
+    Capture pythonMainCameraCapture{(size_t)settings.captureDepth};
+    Capture mainCameraCapture{(size_t)settings.captureDepth};
+    Capture depthCameraCapture{(size_t)settings.captureDepth};
 
     ModelStore modelStore{settings.resourcePath};
 
@@ -49,29 +74,126 @@ public:
         DEPTH_CAMERA,
     } selectedCamera = FPS_CAMERA;
 
-    AutoTracksModule autoTracks;
+    /*
+     * The phases of a frame measured by the profiler,
+     * in the order in which they are passed to the profiler.
+     */
+    enum ProfilerPhase {
+        INPUT_PHASE,
+        SIMULATION_PHASE,
+        AUTOTRACKS_PHASE,
+        COLLISION_PHASE,
+        PHYSICS_PHASE,
+        LASER_SENSORS_PHASE,
+        RULES_PHASE,
+        CAR_VIEW_PHASE,
+        DEPTH_VIEW_PHASE,
+        FPS_VIEW_PHASE,
+        SCREEN_PHASE,
+        GUI_PHASE,
+        CAPTURE_PHASE,
+        SWAP_PHASE,
+    };
+
+    Profiler profiler{{
+        {"input", false},
+        {"simulation", false},
+        {"autotracks", false},
+        {"collision", false},
+        {"physics", false},
+        {"laser sensors", false},
+        {"rules", false},
+        {"car view", true},
+        {"depth view", true},
+        {"fps view", true},
+        {"screen", true},
+        {"gui", true},
+        {"capture", true},
+        {"swap", false},
+    }};
+
+    Simulation simulation;
     CommModule commModule;
     MarkerModule markerModule;
     GuiModule guiModule;
-    ItemsModule itemsModule;
-    CollisionModule collisionModule;
-    RuleModule ruleModule;
     VisModule visModule;
     CarModule car;
     Editor editor;
 
+    /*
+     * The wall clock time (in seconds) spent on simulation ticks
+     * between two displayed frames in fast forward mode.
+     */
+    static constexpr float fastForwardFrameTime = 1.0f / 30.0f;
+
+    /*
+     * The index of the last image of each camera, used to decide
+     * when the camera is due again (see Car::SensorTiming).
+     */
+    int64_t lastMainCameraFrame = -1;
+    int64_t lastDepthCameraFrame = -1;
+
+    /*
+     * The main camera is rendered twice: the bayer image for the
+     * controller (and the recorder), which is rendered whenever the
+     * camera is due, and a color image, which is only rendered if
+     * it is shown on screen or python has asked for it once.
+     */
+    bool pythonMainCameraConsumer = false;
+
+    /*
+     * The states captured after the last two simulation ticks
+     * and the interpolation of both that is actually rendered.
+     */
+    RenderState previousRenderState;
+    RenderState currentRenderState;
+    RenderState renderState;
+
+    /*
+     * In threaded mode the simulation ticks run on their own thread.
+     * The mutex guards the scene and the module states. The render
+     * thread only holds it while the input, the editor and the gui
+     * change the scene and while the render state is taken from it.
+     * The render states of every tick are handed over through the
+     * triple buffer, without waiting on each other.
+     */
+    struct RenderSnapshot {
+        RenderState previous;
+        RenderState current;
+    };
+
+    TripleBuffer<RenderSnapshot> renderSnapshots;
+
+    std::thread simulationThread;
+    std::atomic<bool> simulationRunning{false};
+    std::mutex sceneMutex;
+
     Loop(Settings settings);
     ~Loop();
 
     void update(Scene& scene, float deltaTime);
 
-    void renderScene(Scene& scene, GLuint shaderProgramId);
-    void renderFpsView(Scene& scene);
-    void renderCarView(Scene& scene);
-    void renderDepthView(Scene& scene);
+    void renderScene(RenderState& state, GLuint shaderProgramId);
+    void renderFpsView(Scene& scene, RenderState& state);
+    void renderFpsOverlay(Scene& scene);
+    void renderCarView(Scene& scene, RenderState& state);
+    void renderCarColorView(Scene& scene, RenderState& state);
+    bool isMainCameraColorConsumed();
+    void renderDepthView(Scene& scene, RenderState& state);
+    void renderGui(Scene& scene);
 
     void loop(Scene& scene);
     void step(Scene& scene, float frameDeltaTime);
+    void tick(Scene& scene);
+    void simulate(Scene& scene);
+    void fastForward(Scene& scene);
+    void renderDueSensors(Scene& scene);
+
+    /*
+     * The wall clock time (in seconds) until the next simulation tick
+     * or camera image is due, used to idle in headless mode.
+     */
+    float getIdleTime(Scene& scene);
 };
 
 #endif
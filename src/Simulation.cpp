@@ -0,0 +1,120 @@
+#include "Simulation.h"
+
+#include <limits>
+
+bool isSensorDue(int64_t& lastFrame, Car::SensorTiming& timing, double time) {
+
+    if (timing.rate <= 0) {
+        return false;
+    }
+
+    // a sensor is due once per period, at the first call after
+    // the start of the period. Missed measurements are skipped
+    // and a reset of the simulation clock is handled as well.
+
+    double frame = std::floor((time - (double)timing.phase) * (double)timing.rate);
+
+    if (frame < 0 || (int64_t)frame == lastFrame) {
+        return false;
+    }
+
+    lastFrame = (int64_t)frame;
+
+    return true;
+}
+
+double getNextSensorTime(Car::SensorTiming& timing, double time) {
+
+    if (timing.rate <= 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double frame = std::floor((time - (double)timing.phase) * (double)timing.rate);
+
+    return (frame + 1) / (double)timing.rate + (double)timing.phase;
+}
+
+void Simulation::update(Scene& scene, ModelStore& modelStore, float deltaTime) {
+
+    updateCollisions(scene, modelStore);
+    updatePhysics(scene, deltaTime);
+    updateSensors(scene, modelStore);
+}
+
+void Simulation::updateCollisions(Scene& scene, ModelStore& modelStore) {
+
+    collisionModule.add(scene.car.modelPose, modelStore.car);
+
+    for (auto& i : scene.items) {
+        if (i.type == OBSTACLE) {
+            collisionModule.add(i.pose, modelStore.items[OBSTACLE]);
+        } else if (i.type == DYNAMIC_OBSTACLE) {
+            collisionModule.add(i.pose, modelStore.items[DYNAMIC_OBSTACLE]);
+        } else if (i.type == PEDESTRIAN) {
+            collisionModule.add(i.pose, modelStore.items[PEDESTRIAN]);
+
+        } else if (i.type == DYNAMIC_PEDESTRIAN_RIGHT) {
+            collisionModule.add(i.pose, modelStore.items[PEDESTRIAN]);
+        } else if (i.type == DYNAMIC_PEDESTRIAN_LEFT) {
+            collisionModule.add(i.pose, modelStore.items[PEDESTRIAN]);
+        }
+    }
+
+    collisionModule.update();
+}
+
+void Simulation::updatePhysics(Scene& scene, float deltaTime) {
+
+    if (!scene.paused) {
+        CarModule::updatePosition(scene.car, deltaTime);
+    }
+
+    itemsModule.updateDynamicItems(
+            deltaTime,
+            scene.car, 
+            scene.dynamicItemSettings,
+            scene.items);
+}
+
+void Simulation::updateSensors(Scene& scene, ModelStore& modelStore) {
+
+    if (isSensorDue(
+                lastLaserSensorFrame,
+                scene.car.laserSensor.timing,
+                scene.simulationClock.time)) {
+        CarModule::updateLaserSensor(scene.car, modelStore, scene.items);
+    }
+
+    if (isSensorDue(
+                lastBinaryLightSensorFrame,
+                scene.car.binaryLightSensor.timing,
+                scene.simulationClock.time)) {
+        CarModule::updateBinaryLightSensor(scene.car, modelStore, scene.items);
+    }
+}
+
+bool Simulation::updateRules(Scene& scene) {
+
+    bool noViolation = ruleModule.update(
+            scene.displayClock.time,
+            scene.simulationClock.time,
+            scene.rules,
+            scene.car,
+            scene.tracks,
+            scene.items,
+            collisionModule);
+
+    if (scene.failTime != 0 && scene.enableAutoTracks && noViolation) {
+        scene.failTime = 0;
+    }
+
+    if (scene.failTime == 0 && scene.enableAutoTracks && !noViolation) {
+        scene.failTime = scene.displayClock.time;
+
+        ruleModule.printViolation(
+                scene.simulationClock.time,
+                scene.car.drivenDistance);
+    }
+
+    return noViolation;
+}
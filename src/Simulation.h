@@ -0,0 +1,66 @@
+#ifndef INC_2019_SIMULATION_H
+#define INC_2019_SIMULATION_H
+
+#include "scene/Scene.h"
+#include "scene/ModelStore.h"
+
+#include "modules/AutoTracksModule.h"
+#include "modules/CarModule.h"
+#include "modules/CollisionModule.h"
+#include "modules/ItemsModule.h"
+#include "modules/RuleModule.h"
+
+/*
+ * Returns true once per measurement period of a sensor, at the first call
+ * in that period. The index of the last measurement is kept in lastFrame.
+ */
+bool isSensorDue(int64_t& lastFrame, Car::SensorTiming& timing, double time);
+
+/*
+ * The simulation time at which the measurement period following the
+ * given time starts, infinity if the sensor is disabled.
+ */
+double getNextSensorTime(Car::SensorTiming& timing, double time);
+
+/*
+ * Contains the modules and the state needed to simulate one scene:
+ * physics, collisions, dynamic items, laser sensors and rules.
+ *
+ * Nothing in here renders or communicates, so a Simulation does not
+ * need an OpenGL context and can run on any thread. The ModelStore is
+ * only read (bounding boxes and vertices), thus it can be shared
+ * between multiple simulations.
+ */
+class Simulation {
+
+public:
+
+    AutoTracksModule autoTracks;
+    ItemsModule itemsModule;
+    CollisionModule collisionModule;
+    RuleModule ruleModule;
+
+    /*
+     * The index of the last measurement of the laser
+     * sensors (see Car::SensorTiming).
+     */
+    int64_t lastLaserSensorFrame = -1;
+    int64_t lastBinaryLightSensorFrame = -1;
+
+    /*
+     * Runs all updates of one simulation tick, except for the rules.
+     */
+    void update(Scene& scene, ModelStore& modelStore, float deltaTime);
+
+    void updateCollisions(Scene& scene, ModelStore& modelStore);
+    void updatePhysics(Scene& scene, float deltaTime);
+    void updateSensors(Scene& scene, ModelStore& modelStore);
+
+    /*
+     * Checks the rules and sets (or resets) the fail time of the
+     * scene if autotracks are enabled. Returns false on a violation.
+     */
+    bool updateRules(Scene& scene);
+};
+
+#endif
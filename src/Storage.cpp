@@ -328,6 +328,24 @@ void from_json(const json& j, Car::Wheels& o) {
     o.k_rear = j.at("kRear").get<double>();
 }
 
+/*
+ * Car::SensorTiming
+ */
+
+void to_json(json& j, const Car::SensorTiming& o) {
+
+    j = json({
+            {"rate", o.rate},
+            {"phase", o.phase},
+        });
+}
+
+void from_json(const json& j, Car::SensorTiming& o) {
+
+    tryGet(j, "rate", o.rate);
+    tryGet(j, "phase", o.phase);
+}
+
 /*
  * Car::MainCamera
  */
@@ -340,6 +358,7 @@ void to_json(json& j, const Car::MainCamera& o) {
             {"imageHeight", o.imageHeight},
             {"fov", o.fovy},
             {"noise", o.noise},
+            {"timing", o.timing},
         });
 }
 
@@ -350,6 +369,31 @@ void from_json(const json& j, Car::MainCamera& o) {
     tryGet(j, "imageHeight", o.imageHeight);
     tryGet(j, "fov", o.fovy);
     tryGet(j, "noise", o.noise);
+    tryGet(j, "timing", o.timing);
+}
+
+/*
+ * Car::DepthCamera
+ */
+
+void to_json(json& j, const Car::DepthCamera& o) {
+
+    j = json({
+            {"pose", o.pose},
+            {"depthImageWidth", o.depthImageWidth},
+            {"depthImageHeight", o.depthImageHeight},
+            {"depthFov", o.depthFovy},
+            {"timing", o.timing},
+        });
+}
+
+void from_json(const json& j, Car::DepthCamera& o) {
+
+    tryGet(j, "pose", o.pose);
+    tryGet(j, "depthImageWidth", o.depthImageWidth);
+    tryGet(j, "depthImageHeight", o.depthImageHeight);
+    tryGet(j, "depthFov", o.depthFovy);
+    tryGet(j, "timing", o.timing);
 }
 
 /*
@@ -360,12 +404,14 @@ void to_json(json& j, const Car::LaserSensor& o) {
 
     j = json({
             {"pose", o.pose},
+            {"timing", o.timing},
         });
 }
 
 void from_json(const json& j, Car::LaserSensor& o) {
 
     tryGet(j, "pose", o.pose);
+    tryGet(j, "timing", o.timing);
 }
 
 /*
@@ -377,6 +423,7 @@ void to_json(json& j, const Car::BinaryLightSensor& o) {
     j = json({
             {"pose", o.pose},
             {"triggerDistance", o.triggerDistance},
+            {"timing", o.timing},
         });
 }
 
@@ -384,6 +431,7 @@ void from_json(const json& j, Car::BinaryLightSensor& o) {
 
     tryGet(j, "pose", o.pose);
     tryGet(j, "triggerDistance", o.triggerDistance);
+    tryGet(j, "timing", o.timing);
 }
 
 /*
@@ -399,6 +447,7 @@ void to_json(json& j, const Car& o) {
             {"limits", o.limits},
             {"wheels", o.wheels},
             {"mainCamera", o.mainCamera},
+            {"depthCamera", o.depthCamera},
             {"laserSensor", o.laserSensor},
             {"binaryLightSensor", o.binaryLightSensor}
         });
@@ -412,6 +461,7 @@ void from_json(const json& j, Car& o) {
     tryGet(j, "limits", o.limits);
     tryGet(j, "wheels", o.wheels);
     tryGet(j, "mainCamera", o.mainCamera);
+    tryGet(j, "depthCamera", o.depthCamera);
     tryGet(j, "laserSensor", o.laserSensor);
     tryGet(j, "binaryLightSensor", o.binaryLightSensor);
 }
@@ -699,6 +749,89 @@ void from_json(const json& j, Scene::Rules& r) {
     tryGet(j, "exitIfAllCheckpointsPassed", r.exitIfAllCheckpointsPassed);
 }
 
+/*
+ * Profiler
+ */
+
+/*
+ * Returns the given history of a profiler phase, oldest entry first.
+ */
+std::vector<float> getOrderedHistory(
+        const std::vector<float>& history,
+        size_t historyIndex) {
+
+    std::vector<float> ordered;
+
+    for (size_t i = 0; i < history.size(); i++) {
+        ordered.push_back(history[(historyIndex + i) % history.size()]);
+    }
+
+    return ordered;
+}
+
+void to_json(json& j, const Profiler& p) {
+
+    json phases = json::array();
+
+    for (const Profiler::Phase& phase : p.phases) {
+
+        json jp({
+                {"name", phase.name},
+                {"cpuTimes", getOrderedHistory(phase.cpuTimes, p.cpuHistoryIndex)},
+            });
+
+        if (phase.gpu) {
+            jp["gpuTimes"] = getOrderedHistory(phase.gpuTimes, p.gpuHistoryIndex);
+        }
+
+        phases.push_back(jp);
+    }
+
+    j = json({
+            {"unit", "ms"},
+            {"phases", phases},
+        });
+}
+
+/*
+ * Latencies
+ */
+
+void to_json(json& j, const LatencyHistogram& h) {
+
+    std::vector<double> binStarts;
+
+    for (size_t i = 0; i < LatencyHistogram::BIN_COUNT; i++) {
+        binStarts.push_back(LatencyHistogram::getBinStart(i));
+    }
+
+    j = json({
+            {"count", h.count},
+            {"min", h.min},
+            {"max", h.max},
+            {"mean", h.getMean()},
+            {"p50", h.getPercentile(0.5)},
+            {"p90", h.getPercentile(0.9)},
+            {"p99", h.getPercentile(0.99)},
+            {"binStarts", binStarts},
+            {"bins", h.bins},
+        });
+}
+
+void to_json(json& j, const ChannelLatency& l) {
+
+    j = json({
+            {"name", l.name},
+            {"unit", "ms"},
+            {"published", l.published},
+            {"dropped", l.dropped},
+            {"readback", l.readback},
+            {"publish", l.publish},
+            {"acquire", l.acquire},
+            {"total", l.total},
+        });
+}
+
 /*
  * Scene
  */
@@ -901,6 +1034,51 @@ namespace storage {
     template bool load<Scene>(Scene& t, std::string path);
     template bool save<Scene>(Scene& t, std::string path);
 
+    template bool save<Profiler>(Profiler& t, std::string path);
+    template bool save<std::vector<ChannelLatency>>(
+            std::vector<ChannelLatency>& t, std::string path);
+
+    bool saveCsv(Profiler& profiler, std::string path) {
+
+        std::ofstream out(path);
+
+        if (!out) {
+            return false;
+        }
+
+        out << "frame";
+
+        for (Profiler::Phase& phase : profiler.phases) {
+            out << "," << phase.name << " cpu [ms]";
+            if (phase.gpu) {
+                out << "," << phase.name << " gpu [ms]";
+            }
+        }
+
+        out << "\n";
+
+        for (size_t i = 0; i < Profiler::HISTORY_SIZE; i++) {
+
+            size_t cpuIndex = (profiler.cpuHistoryIndex + i) % Profiler::HISTORY_SIZE;
+            size_t gpuIndex = (profiler.gpuHistoryIndex + i) % Profiler::HISTORY_SIZE;
+
+            out << i;
+
+            for (Profiler::Phase& phase : profiler.phases) {
+                out << "," << phase.cpuTimes[cpuIndex];
+                if (phase.gpu) {
+                    out << "," << phase.gpuTimes[gpuIndex];
+                }
+            }
+
+            out << "\n";
+        }
+
+        out.close();
+
+        return true;
+    }
+
     void convertMaterial(objl::Material& meshMat, Model::Material& mat) {
 
         mat.name = meshMat.name;
@@ -959,6 +1137,9 @@ namespace storage {
                model.vertices.emplace_back();
                convertVertex(v, model.vertices.back());
             }
+
+            model.indices.assign(mesh.Indices.begin(), mesh.Indices.end());
+            model.indexVertices();
         } else {
             for (objl::Mesh& mesh : loader.LoadedMeshes) {
                 model.subModels.emplace_back(model.storageType);
@@ -970,6 +1151,9 @@ namespace storage {
                    subModel.vertices.emplace_back();
                    convertVertex(v, subModel.vertices.back());
                 }
+
+                subModel.indices.assign(mesh.Indices.begin(), mesh.Indices.end());
+                subModel.indexVertices();
             }
         }
 
@@ -5,6 +5,8 @@
 
 #include "scene/Settings.h"
 
+class Profiler;
+
 namespace storage { 
 
     /*
@@ -50,6 +52,12 @@ namespace storage {
      */
     bool load(Settings& settings);
     bool save(Settings& settings);
+
+    /*
+     * Writes the profiler history as comma separated values,
+     * one line per frame, one column per phase (cpu and gpu).
+     */
+    bool saveCsv(Profiler& profiler, std::string path);
 }
 
 #endif
@@ -14,22 +14,16 @@ glm::mat4 Camera::getProjectionMatrix() {
     return glm::perspective(fov, aspectRatio, 0.1f, 100.0f);
 }
 
-void Camera::render(GLuint shaderProgramId) {
+void Camera::render(UniformBuffer& cameraUniformBuffer) {
 
-    glm::mat4 projection = getProjectionMatrix();
-    glm::mat4 view = pose.getInverseMatrix();
-
-    GLint viewLocation =
-        glGetUniformLocation(shaderProgramId, "view");
-    glUniformMatrix4fv(viewLocation, 1, GL_FALSE, &view[0][0]);
+    UniformBlock block;
 
-    GLint projectionLocation =
-        glGetUniformLocation(shaderProgramId, "projection");
-    glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, &projection[0][0]);
+    block.view = pose.getInverseMatrix();
+    block.projection = getProjectionMatrix();
+    block.cameraPosition = pose.position;
+    block.padding = 0;
 
-    GLint posLocation =
-        glGetUniformLocation(shaderProgramId, "cameraPosition");
-    glUniform3fv(posLocation, 1, glm::value_ptr(pose.position));
+    cameraUniformBuffer.update(&block);
 }
 
 glm::vec3 Camera::pickRay(double x, double y, int windowWidth, int windowHeight) {
@@ -9,6 +9,7 @@
 #include <GLFW/glfw3.h>
 
 #include "Pose.h"
+#include "UniformBuffer.h"
 
 class Camera {
 
@@ -25,13 +26,23 @@ public:
      */
     Pose pose;
 
+    /*
+     * The std140 layout of the "Camera" uniform block.
+     */
+    struct UniformBlock {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec3 cameraPosition;
+        float padding;
+    };
+
     virtual glm::mat4 getProjectionMatrix();
 
     /*
-     * This sets the uniform variables "view" "projection"
-     * and "cameraPosition" in the currently bound shader program.
+     * This writes "view", "projection" and "cameraPosition" to the
+     * camera uniform buffer, which is shared by all shader programs.
      */
-    void render(GLuint shaderProgramId);
+    void render(UniformBuffer& cameraUniformBuffer);
 
     /*
      * This function will return a vector, from the origin of the camera through
@@ -2,59 +2,212 @@
 
 #include <cstring>
 
-Capture::Capture() {
+Capture::Capture(size_t depth) : slots(depth < 2 ? 2 : depth) {
 
-    pboWidth = 0;
-    pboHeight = 0;
-    pboIndex = 0;
-
-    glGenBuffers(2, pboIds);
+    // immutable buffer storage is needed for persistent mappings
+    persistent = GLEW_ARB_buffer_storage;
 }
 
 Capture::~Capture() {
 
-    glDeleteBuffers(2, pboIds);
+    release();
 }
 
-bool Capture::capture(
-        GLubyte* buffer,
+void Capture::drop(Slot& slot) {
+
+    if (slot.fence != nullptr) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+}
+
+void Capture::release() {
+
+    for (Slot& slot : slots) {
+
+        drop(slot);
+
+        if (slot.pointer != nullptr) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            slot.pointer = nullptr;
+        }
+
+        if (slot.pbo != 0) {
+            glDeleteBuffers(1, &slot.pbo);
+            slot.pbo = 0;
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void Capture::allocate(GLsizeiptr size) {
+
+    // immutable storage can not be resized, so the buffers are
+    // created again instead. Images of the old size are dropped.
+
+    release();
+
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    for (Slot& slot : slots) {
+
+        glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+
+        if (persistent) {
+            glBufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+            slot.pointer = (GLubyte*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+        } else {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    pboSize = size;
+}
+
+void Capture::read(
         GLsizei width,
         GLsizei height,
         GLsizei elementSize,
         GLenum format,
-        GLenum dataType) {
+        GLenum dataType,
+        uint64_t id) {
 
-    GLsizei dataSize = width * height * elementSize;
+    GLsizeiptr dataSize = (GLsizeiptr)width * height * elementSize;
 
-    if (pboWidth != width || pboHeight != height) {
+    if (pboWidth != width || pboHeight != height || pboSize != dataSize) {
         pboHeight = height;
         pboWidth = width;
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[0]);
-        glBufferData(GL_PIXEL_PACK_BUFFER, dataSize, nullptr, GL_STREAM_READ);
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[1]);
-        glBufferData(GL_PIXEL_PACK_BUFFER, dataSize, nullptr, GL_STREAM_READ);
+        allocate(dataSize);
     }
 
-    pboIndex = (pboIndex + 1) % 2;
-    int nextIndex = (pboIndex + 1) % 2;
+    // the next slot is the oldest one, if its
+    // image was not retrieved yet it is dropped
 
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[pboIndex]);
+    Slot& slot = slots[nextSlot];
+    nextSlot = (nextSlot + 1) % slots.size();
+
+    drop(slot);
+
+    // rows are tightly packed, the default alignment of four
+    // bytes would pad rows of odd widths and overflow the buffer
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
     glReadPixels(
         0, 0,
         width, height,
         format,
         dataType,
         nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.id = id;
+    slot.sequence = ++sequence;
+}
+
+Capture::Slot* Capture::findCompleted() {
+
+    Slot* newest = nullptr;
+
+    for (Slot& slot : slots) {
 
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[nextIndex]);
-    GLubyte* ptr = (GLubyte*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (slot.fence == nullptr) {
+            continue;
+        }
 
-    if (ptr) {
-        memcpy(buffer, ptr, (size_t)dataSize);
-        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        if (synchronous) {
+            if (newest == nullptr || slot.sequence > newest->sequence) {
+                newest = &slot;
+            }
+            continue;
+        }
+
+        // a timeout of zero only polls the state of the fence
+
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        bool completed = status == GL_ALREADY_SIGNALED
+            || status == GL_CONDITION_SATISFIED;
+
+        if (completed && (newest == nullptr || slot.sequence > newest->sequence)) {
+            newest = &slot;
+        }
     }
 
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (synchronous && newest != nullptr) {
+        glClientWaitSync(newest->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    }
+
+    return newest;
+}
+
+bool Capture::isAvailable() {
+
+    return findCompleted() != nullptr;
+}
+
+bool Capture::retrieve(GLubyte* buffer, uint64_t& id) {
+
+    Slot* newest = findCompleted();
+
+    if (newest == nullptr) {
+        return false;
+    }
+
+    bool success = false;
+
+    if (persistent) {
+        if (newest->pointer != nullptr) {
+            memcpy(buffer, newest->pointer, (size_t)pboSize);
+            success = true;
+        }
+    } else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, newest->pbo);
+
+        // the transfer is complete, so mapping does not stall
+        GLubyte* ptr = (GLubyte*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+
+        if (ptr) {
+            memcpy(buffer, ptr, (size_t)pboSize);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            success = true;
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    id = newest->id;
+
+    // images older than the retrieved one are of no use anymore
+
+    uint64_t retrievedSequence = newest->sequence;
+
+    for (Slot& slot : slots) {
+        if (slot.sequence <= retrievedSequence) {
+            drop(slot);
+        }
+    }
+
+    return success;
+}
+
+bool Capture::capture(
+        GLubyte* buffer,
+        GLsizei width,
+        GLsizei height,
+        GLsizei elementSize,
+        GLenum format,
+        GLenum dataType) {
+
+    uint64_t id = 0;
+
+    read(width, height, elementSize, format, dataType, id);
 
-    return ptr != nullptr;
+    return retrieve(buffer, id);
 }
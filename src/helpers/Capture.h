@@ -1,22 +1,124 @@
 #ifndef INC_2019_CAPTURE_H
 #define INC_2019_CAPTURE_H
 
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+/*
+ * Reads images from the currently bound framebuffer asynchronously.
+ *
+ * The images are read into a ring of pixel buffers. A fence is placed
+ * behind every read, and an image is only handed out once its fence
+ * is signaled, so the render thread never waits for a transfer. If the
+ * gpu falls behind so far that the ring is full, the oldest image that
+ * is still in flight is dropped.
+ *
+ * If buffer storage is available, the pixel buffers are mapped once
+ * and stay mapped (persistent and coherent in client memory), so the
+ * gpu writes the pixels directly into memory the cpu can read and the
+ * only copy left is the one into the buffer of the caller (e.g. the
+ * shared memory). Otherwise the buffers are mapped for every image.
+ */
 class Capture {
 
-    GLsizei pboWidth;
-    GLsizei pboHeight;
+    struct Slot {
+
+        GLuint pbo = 0;
+
+        /*
+         * The persistent mapping of the buffer,
+         * nullptr if buffer storage is not used.
+         */
+        GLubyte* pointer = nullptr;
+
+        /*
+         * Signaled when the transfer into the buffer is complete,
+         * nullptr if the buffer holds no image that is to be read.
+         */
+        GLsync fence = nullptr;
+
+        /*
+         * The id the image was read with.
+         */
+        uint64_t id = 0;
+
+        /*
+         * Increasing number of the read, to find the newest image.
+         */
+        uint64_t sequence = 0;
+    };
+
+    std::vector<Slot> slots;
+
+    size_t nextSlot = 0;
+    uint64_t sequence = 0;
+
+    GLsizei pboWidth = 0;
+    GLsizei pboHeight = 0;
+    GLsizeiptr pboSize = 0;
+
+    bool persistent;
 
-    int pboIndex;
-    GLuint pboIds[2];
+    void allocate(GLsizeiptr size);
+    void release();
+    void drop(Slot& slot);
+
+    /*
+     * Returns the newest slot with a completed transfer or nullptr.
+     * In synchronous mode this waits for the newest read instead.
+     */
+    Slot* findCompleted();
 
 public:
 
-    Capture();
+    /*
+     * Usually the images are handed out a few frames after they were
+     * read, which avoids waiting for the transfer. If set, retrieve
+     * waits for the newest image instead (at the cost of a stall).
+     */
+    bool synchronous = false;
+
+    /*
+     * The depth is the number of images that can be in flight.
+     */
+    explicit Capture(size_t depth = 3);
     ~Capture();
 
+    Capture(const Capture&) = delete;
+    Capture& operator=(const Capture&) = delete;
+
+    /*
+     * Starts reading the image of the bound framebuffer. The id
+     * (e.g. a sequence number or tick) is handed out again together
+     * with the image, to find out which image was retrieved.
+     */
+    void read(
+            GLsizei width,
+            GLsizei height,
+            GLsizei elementSize,
+            GLenum format,
+            GLenum dataType,
+            uint64_t id);
+
+    /*
+     * Returns true if retrieve would hand out an image.
+     */
+    bool isAvailable();
+
+    /*
+     * Copies the newest completed image into the buffer and sets the
+     * id it was read with. Older images that were not retrieved are
+     * dropped. Returns false if no image is complete.
+     */
+    bool retrieve(GLubyte* buffer, uint64_t& id);
+
+    /*
+     * Reads the current image and retrieves the newest completed one.
+     */
     bool capture(
             GLubyte* buffer,
             GLsizei width,
@@ -0,0 +1,196 @@
+#include "ChannelRecorder.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+constexpr char ChannelRecorder::FILE_MAGIC[8];
+constexpr char ChannelRecorder::CHUNK_MAGIC[8];
+constexpr char ChannelRecorder::INDEX_MAGIC[8];
+
+static size_t padToEight(size_t size) {
+
+    return (size + 7) & ~(size_t)7;
+}
+
+ChannelRecorder::ChannelRecorder(
+        std::string path,
+        std::vector<Channel> channels,
+        size_t chunkSize,
+        size_t maxQueuedSize)
+    : out{path, std::ios::binary | std::ios::trunc}
+    , chunkSize{chunkSize}
+    , maxQueuedSize{maxQueuedSize} {
+
+    if (!out) {
+        std::cerr << "Could not open " << path << " for recording." << std::endl;
+        return;
+    }
+
+    FileHeader header{};
+
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.channelCount = 0;
+
+    for (Channel& channel : channels) {
+        if (header.channelCount < MAX_CHANNELS) {
+            header.channels[header.channelCount++] = channel;
+        }
+    }
+
+    writeBytes(&header, sizeof(header));
+
+    writer = std::thread(&ChannelRecorder::write, this);
+}
+
+ChannelRecorder::~ChannelRecorder() {
+
+    if (!writer.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    condition.notify_one();
+    writer.join();
+
+    flushChunk();
+
+    // the index allows to seek without reading all chunks
+
+    Footer footer{};
+
+    footer.indexOffset = fileOffset;
+    footer.chunkCount = index.size();
+    std::memcpy(footer.magic, INDEX_MAGIC, sizeof(footer.magic));
+
+    writeBytes(index.data(), index.size() * sizeof(IndexEntry));
+    writeBytes(&footer, sizeof(footer));
+
+    if (droppedMessages > 0) {
+        std::cerr << "Recording dropped "
+                  << droppedMessages
+                  << " messages, the disk was too slow." << std::endl;
+    }
+}
+
+bool ChannelRecorder::isOpen() {
+
+    return writer.joinable();
+}
+
+void ChannelRecorder::record(uint32_t channel, const void* data, size_t size) {
+
+    if (!writer.joinable()) {
+        return;
+    }
+
+    std::vector<char> message(sizeof(MessageHeader) + padToEight(size), 0);
+
+    MessageHeader header;
+    header.channel = channel;
+    header.size = (uint32_t)size;
+    header.time = std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    std::memcpy(message.data(), &header, sizeof(header));
+    std::memcpy(message.data() + sizeof(header), data, size);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (queuedSize + message.size() > maxQueuedSize) {
+            droppedMessages++;
+            return;
+        }
+
+        queuedSize += message.size();
+        queue.push_back(std::move(message));
+    }
+
+    condition.notify_one();
+}
+
+uint64_t ChannelRecorder::getDroppedMessages() {
+
+    return droppedMessages;
+}
+
+void ChannelRecorder::write() {
+
+    std::deque<std::vector<char>> messages;
+
+    while (true) {
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            condition.wait(lock, [&]{ return stopping || !queue.empty(); });
+
+            if (queue.empty() && stopping) {
+                return;
+            }
+
+            std::swap(messages, queue);
+        }
+
+        // the disk is written without holding the lock. The messages
+        // count against the queue limit until they are written.
+
+        for (std::vector<char>& message : messages) {
+            append(message);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            queuedSize -= message.size();
+        }
+
+        messages.clear();
+    }
+}
+
+void ChannelRecorder::append(std::vector<char>& message) {
+
+    MessageHeader header;
+    std::memcpy(&header, message.data(), sizeof(header));
+
+    if (chunkHeader.messageCount == 0) {
+        chunkHeader.firstTime = header.time;
+    }
+
+    chunkHeader.lastTime = header.time;
+    chunkHeader.messageCount++;
+
+    chunk.insert(chunk.end(), message.begin(), message.end());
+
+    if (chunk.size() >= chunkSize) {
+        flushChunk();
+    }
+}
+
+void ChannelRecorder::flushChunk() {
+
+    if (chunkHeader.messageCount == 0) {
+        return;
+    }
+
+    std::memcpy(chunkHeader.magic, CHUNK_MAGIC, sizeof(chunkHeader.magic));
+    chunkHeader.size = chunk.size();
+
+    index.push_back({fileOffset, chunkHeader.firstTime});
+
+    writeBytes(&chunkHeader, sizeof(chunkHeader));
+    writeBytes(chunk.data(), chunk.size());
+
+    chunk.clear();
+    chunkHeader = ChunkHeader{};
+}
+
+void ChannelRecorder::writeBytes(const void* data, size_t size) {
+
+    out.write((const char*)data, size);
+    fileOffset += size;
+}
@@ -0,0 +1,158 @@
+#ifndef INC_2019_CHANNELRECORDER_H
+#define INC_2019_CHANNELRECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Appends the messages sent over the shared memory channels to a
+ * binary log file, which can be played back with ChannelReplayer.
+ *
+ * The messages are copied into a queue and written by a background
+ * thread, so recording never waits for the disk. If the disk can not
+ * keep up and the queue grows too large, messages are dropped.
+ *
+ * Layout of the file (all structs 8 byte aligned):
+ *
+ *   FileHeader
+ *   chunks, each a ChunkHeader followed by messageCount times
+ *           a MessageHeader and the message data (padded to 8 bytes)
+ *   index, one IndexEntry per chunk
+ *   Footer
+ *
+ * The index and footer are written when the recorder is destroyed.
+ * Logs without them (e.g. after a crash) can still be played back
+ * by walking through the chunks.
+ */
+class ChannelRecorder {
+
+public:
+
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t MAX_CHANNELS = 16;
+
+    static constexpr char FILE_MAGIC[8] = {'S', 'P', 'Z', 'L', 'O', 'G', '0', '1'};
+    static constexpr char CHUNK_MAGIC[8] = {'S', 'P', 'Z', 'C', 'H', 'N', 'K', '1'};
+    static constexpr char INDEX_MAGIC[8] = {'S', 'P', 'Z', 'I', 'D', 'X', '0', '1'};
+
+    struct Channel {
+
+        char name[32];
+
+        int32_t key;
+        uint32_t schemaVersion;
+    };
+
+    struct FileHeader {
+
+        char magic[8];
+
+        uint32_t version;
+        uint32_t channelCount;
+
+        Channel channels[MAX_CHANNELS];
+    };
+
+    struct ChunkHeader {
+
+        char magic[8];
+
+        /*
+         * The number of bytes following this header.
+         */
+        uint64_t size;
+
+        uint32_t messageCount;
+        uint32_t reserved;
+
+        double firstTime;
+        double lastTime;
+    };
+
+    struct MessageHeader {
+
+        /*
+         * The index of the channel in the file header.
+         */
+        uint32_t channel;
+
+        /*
+         * The size of the data, without padding.
+         */
+        uint32_t size;
+
+        /*
+         * Seconds of the monotonic clock when the message was recorded.
+         */
+        double time;
+    };
+
+    struct IndexEntry {
+
+        uint64_t offset;
+        double firstTime;
+    };
+
+    struct Footer {
+
+        uint64_t indexOffset;
+        uint64_t chunkCount;
+
+        char magic[8];
+    };
+
+    ChannelRecorder(
+            std::string path,
+            std::vector<Channel> channels,
+            size_t chunkSize = 4 << 20,
+            size_t maxQueuedSize = 256 << 20);
+    ~ChannelRecorder();
+
+    ChannelRecorder(const ChannelRecorder&) = delete;
+    ChannelRecorder& operator=(const ChannelRecorder&) = delete;
+
+    bool isOpen();
+
+    /*
+     * Queues the message for writing, may be called from any thread.
+     */
+    void record(uint32_t channel, const void* data, size_t size);
+
+    uint64_t getDroppedMessages();
+
+private:
+
+    std::ofstream out;
+    uint64_t fileOffset = 0;
+
+    size_t chunkSize;
+    size_t maxQueuedSize;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::vector<char>> queue;
+    size_t queuedSize = 0;
+    bool stopping = false;
+
+    std::atomic<uint64_t> droppedMessages{0};
+
+    std::vector<char> chunk;
+    ChunkHeader chunkHeader{};
+    std::vector<IndexEntry> index;
+
+    std::thread writer;
+
+    void write();
+    void append(std::vector<char>& message);
+    void flushChunk();
+    void writeBytes(const void* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,254 @@
+#include "ChannelReplayer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ChannelReplayer::ChannelReplayer(std::string path) {
+
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        std::cerr << "Could not open " << path << " for replay." << std::endl;
+        return;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ChannelRecorder::FileHeader)) {
+        void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (ptr != MAP_FAILED) {
+            data = (const char*)ptr;
+            size = st.st_size;
+        }
+    }
+
+    close(fd);
+
+    if (nullptr == data) {
+        std::cerr << "Could not map " << path << " for replay." << std::endl;
+        return;
+    }
+
+    // the messages are read once from front to back
+    madvise((void*)data, size, MADV_SEQUENTIAL);
+
+    header = (const ChannelRecorder::FileHeader*)data;
+
+    if (0 != std::memcmp(header->magic, ChannelRecorder::FILE_MAGIC, sizeof(header->magic))
+            || header->version != ChannelRecorder::VERSION) {
+        std::cerr << path << " is not a channel log of version "
+                  << ChannelRecorder::VERSION << "." << std::endl;
+        munmap((void*)data, size);
+        data = nullptr;
+        header = nullptr;
+        return;
+    }
+
+    readIndex();
+
+    if (chunks.empty()) {
+        scanChunks();
+    }
+}
+
+ChannelReplayer::~ChannelReplayer() {
+
+    if (nullptr != data) {
+        munmap((void*)data, size);
+    }
+}
+
+bool ChannelReplayer::isOpen() {
+
+    return nullptr != data;
+}
+
+void ChannelReplayer::readIndex() {
+
+    if (size < sizeof(ChannelRecorder::FileHeader) + sizeof(ChannelRecorder::Footer)) {
+        return;
+    }
+
+    const ChannelRecorder::Footer* footer = (const ChannelRecorder::Footer*)
+        (data + size - sizeof(ChannelRecorder::Footer));
+
+    if (0 != std::memcmp(footer->magic, ChannelRecorder::INDEX_MAGIC, sizeof(footer->magic))) {
+        return;
+    }
+
+    // checked one by one, so that garbage can not overflow the sum
+
+    if (footer->indexOffset > size
+            || footer->chunkCount > size / sizeof(ChannelRecorder::IndexEntry)) {
+        return;
+    }
+
+    size_t indexSize = footer->chunkCount * sizeof(ChannelRecorder::IndexEntry);
+
+    if (footer->indexOffset + indexSize + sizeof(ChannelRecorder::Footer) != size) {
+        return;
+    }
+
+    const ChannelRecorder::IndexEntry* entries =
+        (const ChannelRecorder::IndexEntry*)(data + footer->indexOffset);
+
+    // the footer may match by chance, thus every chunk is checked
+    // like scanChunks does, the chunks are found by scanning otherwise
+
+    for (uint64_t i = 0; i < footer->chunkCount; i++) {
+        if (!isValidChunk(entries[i].offset, footer->indexOffset)) {
+            return;
+        }
+    }
+
+    chunks.assign(entries, entries + footer->chunkCount);
+}
+
+bool ChannelReplayer::isValidChunk(uint64_t offset, uint64_t end) {
+
+    if (offset < sizeof(ChannelRecorder::FileHeader)
+            || offset > end
+            || end - offset < sizeof(ChannelRecorder::ChunkHeader)) {
+        return false;
+    }
+
+    const ChannelRecorder::ChunkHeader* chunk =
+        (const ChannelRecorder::ChunkHeader*)(data + offset);
+
+    return 0 == std::memcmp(chunk->magic, ChannelRecorder::CHUNK_MAGIC, sizeof(chunk->magic))
+        && chunk->size <= end - offset - sizeof(ChannelRecorder::ChunkHeader);
+}
+
+void ChannelReplayer::scanChunks() {
+
+    // without index (the recording was not finished properly)
+    // the chunks are found by following their sizes
+
+    size_t offset = sizeof(ChannelRecorder::FileHeader);
+
+    while (offset + sizeof(ChannelRecorder::ChunkHeader) <= size) {
+
+        if (!isValidChunk(offset, size)) {
+            break;
+        }
+
+        const ChannelRecorder::ChunkHeader* chunk =
+            (const ChannelRecorder::ChunkHeader*)(data + offset);
+
+        chunks.push_back({offset, chunk->firstTime});
+
+        offset += sizeof(ChannelRecorder::ChunkHeader) + chunk->size;
+    }
+}
+
+void ChannelReplayer::replay(
+        float speed,
+        double startOffset,
+        std::function<int(int)> channelKey,
+        SimulatorSHM::Backend backend,
+        bool hugePages) {
+
+    if (!isOpen() || chunks.empty()) {
+        return;
+    }
+
+    // the channels are attached with the size of their first message
+
+    std::vector<std::unique_ptr<SimulatorSHM::SHMComm<char>>> channels(
+            std::min(header->channelCount, (uint32_t)ChannelRecorder::MAX_CHANNELS));
+
+    std::vector<size_t> channelSizes(channels.size(), 0);
+
+    double firstTime = chunks.front().firstTime;
+    double startTime = firstTime + startOffset;
+
+    // the index allows to skip to the first chunk containing the start
+
+    size_t firstChunk = 0;
+
+    while (firstChunk + 1 < chunks.size() && chunks[firstChunk + 1].firstTime <= startTime) {
+        firstChunk++;
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    for (size_t c = firstChunk; c < chunks.size(); c++) {
+
+        const ChannelRecorder::ChunkHeader* chunk =
+            (const ChannelRecorder::ChunkHeader*)(data + chunks[c].offset);
+
+        const char* ptr = (const char*)(chunk + 1);
+        const char* end = ptr + chunk->size;
+
+        for (uint32_t m = 0; m < chunk->messageCount; m++) {
+
+            if (ptr + sizeof(ChannelRecorder::MessageHeader) > end) {
+                break;
+            }
+
+            const ChannelRecorder::MessageHeader* message =
+                (const ChannelRecorder::MessageHeader*)ptr;
+
+            const char* messageData = ptr + sizeof(ChannelRecorder::MessageHeader);
+
+            ptr = messageData + ((message->size + 7) & ~(uint32_t)7);
+
+            if (message->time < startTime
+                    || message->channel >= channels.size()
+                    || messageData + message->size > end) {
+                continue;
+            }
+
+            if (speed > 0) {
+                std::this_thread::sleep_until(wallStart
+                        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(
+                                (message->time - startTime) / speed)));
+            }
+
+            std::unique_ptr<SimulatorSHM::SHMComm<char>>& channelPtr = channels[message->channel];
+
+            // an existing segment of the same size is attached to (and
+            // replaced otherwise), later size changes recreate the segment
+
+            bool ready = true;
+
+            if (!channelPtr) {
+                channelPtr.reset(new SimulatorSHM::SHMComm<char>(
+                            channelKey(header->channels[message->channel].key),
+                            message->size));
+                channelPtr->setBackend(backend, hugePages);
+                ready = channelPtr->attach();
+            } else if (channelSizes[message->channel] != message->size) {
+                ready = channelPtr->create(message->size);
+            }
+
+            if (!ready) {
+                std::cerr << "Could not create the shared memory for "
+                          << header->channels[message->channel].name << "." << std::endl;
+                return;
+            }
+
+            channelSizes[message->channel] = message->size;
+
+            SimulatorSHM::SHMComm<char>& channel = *channelPtr;
+
+            char* obj = channel.lock(SimulatorSHM::WRITE_OVERWRITE_OLDEST);
+
+            if (obj != nullptr) {
+                std::memcpy(obj, messageData, message->size);
+                channel.unlock(obj);
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef INC_2019_CHANNELREPLAYER_H
+#define INC_2019_CHANNELREPLAYER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ChannelRecorder.h"
+#include "sharedmem/shmcomm.h"
+
+/*
+ * Plays back a log written by ChannelRecorder: every message is
+ * published again into the channel (shared memory key) it was
+ * recorded from, or the key it is mapped to. The log is mapped into
+ * memory, so the messages are copied straight from the page cache
+ * into the shared memory.
+ *
+ * Existing segments of the right size are attached to, so consumers
+ * keep reading. Camera channels are recreated whenever the size of
+ * the recorded messages changes, like the simulator does when the
+ * resolution changes. No simulator may run on the same keys at the
+ * same time.
+ */
+class ChannelReplayer {
+
+    const char* data = nullptr;
+    size_t size = 0;
+
+    const ChannelRecorder::FileHeader* header = nullptr;
+
+    /*
+     * The offsets of the chunks, from the index or, if the
+     * log has no index, found by walking through the chunks.
+     */
+    std::vector<ChannelRecorder::IndexEntry> chunks;
+
+    void readIndex();
+    void scanChunks();
+
+    /*
+     * True if a complete chunk starts at the offset
+     * and ends before the given end offset.
+     */
+    bool isValidChunk(uint64_t offset, uint64_t end);
+
+public:
+
+    explicit ChannelReplayer(std::string path);
+    ~ChannelReplayer();
+
+    ChannelReplayer(const ChannelReplayer&) = delete;
+    ChannelReplayer& operator=(const ChannelReplayer&) = delete;
+
+    bool isOpen();
+
+    /*
+     * Publishes the messages with the recorded timing, divided by the
+     * speed (a speed of 0 publishes as fast as possible). Playback
+     * starts at the given number of seconds after the first message.
+     * The messages of a recorded key are published to channelKey(key).
+     */
+    void replay(
+            float speed,
+            double startOffset,
+            std::function<int(int)> channelKey,
+            SimulatorSHM::Backend backend,
+            bool hugePages);
+};
+
+#endif
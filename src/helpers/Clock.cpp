@@ -1,6 +1,6 @@
 #include "Clock.h"
 
-Clock::Clock() : time{0.0}, accumulator{0.0f} {
+Clock::Clock() : time{0.0}, accumulator{0.0f}, ticks{0} {
 }
 
 void Clock::windup(float deltaTime) {
@@ -13,6 +13,7 @@ bool Clock::step(float deltaTime) {
     if (accumulator >= deltaTime) {
         accumulator -= deltaTime;
         time += deltaTime;
+        ticks++;
         return true;
     } else {
         return false;
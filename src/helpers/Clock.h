@@ -2,6 +2,7 @@
 #define INC_2019_CLOCK_H
 
 #include <chrono>
+#include <cstdint>
 
 class Clock {
 
@@ -12,6 +13,11 @@ public:
     double time;
     float accumulator;
 
+    /*
+     * The number of steps taken, i.e. the simulation tick.
+     */
+    uint64_t ticks;
+
     void windup(float deltaTime);
     bool step(float deltaTime);
 };
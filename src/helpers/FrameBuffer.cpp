@@ -9,11 +9,12 @@ FrameBuffer::FrameBuffer(
         GLsizei height, 
         GLsizei samples, 
         GLint internalFormatColor, 
-        GLenum formatColor) {
+        GLenum formatColor,
+        GLenum typeColor) {
 
     glGenFramebuffers(1, &id);
 
-    resize(width, height, samples, internalFormatColor, formatColor);
+    resize(width, height, samples, internalFormatColor, formatColor, typeColor);
 
     glBindFramebuffer(GL_FRAMEBUFFER, id);
 
@@ -40,7 +41,8 @@ void FrameBuffer::resize(
         GLsizei height, 
         GLsizei samples, 
         GLint internalFormatColor,
-        GLenum formatColor) {
+        GLenum formatColor,
+        GLenum typeColor) {
 
     if (samples < 1) {
         samples = this->samples;
@@ -51,6 +53,9 @@ void FrameBuffer::resize(
     if (0 == formatColor) {
         formatColor = this->formatColor;
     }
+    if (0 == typeColor) {
+        typeColor = this->typeColor;
+    }
 
     // only resize if absolutely necessary
 
@@ -58,7 +63,8 @@ void FrameBuffer::resize(
             && this->height == height
             && this->samples == samples
             && this->internalFormatColor == internalFormatColor
-            && this->formatColor == formatColor) { 
+            && this->formatColor == formatColor
+            && this->typeColor == typeColor) { 
         return;
     }
 
@@ -99,7 +105,7 @@ void FrameBuffer::resize(
                      height,
                      0,
                      formatColor,
-                     GL_FLOAT,
+                     typeColor,
                      0);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -167,5 +173,6 @@ void FrameBuffer::resize(
     this->samples = samples;
     this->internalFormatColor = internalFormatColor;
     this->formatColor = formatColor;
+    this->typeColor = typeColor;
 }
 
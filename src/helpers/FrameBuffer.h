@@ -16,6 +16,10 @@
  * Internally a frame buffer object is created that holds a
  * rgba texture for the color and 24 bit depth texture for 
  * depth information.
+ *
+ * The format of the color texture can be chosen, compact formats
+ * (e.g. GL_R8 for single channel images) save fill rate, memory
+ * and bandwidth when the image is read back.
  */
 class FrameBuffer {
 
@@ -33,13 +37,21 @@ public:
     GLint internalFormatColor = GL_RGBA;
     GLenum formatColor = GL_RGBA;
 
+    /*
+     * The type of the (empty) pixel data the color texture is
+     * allocated with, must be compatible with the internal format
+     * (e.g. GL_UNSIGNED_BYTE for normalized integer formats).
+     */
+    GLenum typeColor = GL_FLOAT;
+
     FrameBuffer(GLsizei width, GLsizei height);
     FrameBuffer(
             GLsizei width,
             GLsizei height, 
             GLsizei samples, 
             GLint internalFormatColor, 
-            GLenum formatColor);
+            GLenum formatColor,
+            GLenum typeColor = GL_FLOAT);
 
     ~FrameBuffer();
 
@@ -47,7 +59,8 @@ public:
             GLsizei height, 
             GLsizei samples = -1, 
             GLint internalFormatColor = 0,
-            GLenum formatColor = 0);
+            GLenum formatColor = 0,
+            GLenum typeColor = 0);
 };
 
 #endif
@@ -0,0 +1,113 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+#include <cstdlib>
+
+#ifdef SPATZSIM_WITH_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext(bool enable) {
+
+    if (!enable) {
+        return;
+    }
+
+#ifdef SPATZSIM_WITH_EGL
+    EGLDisplay eglDisplay = eglGetPlatformDisplay(
+            EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+    if (EGL_NO_DISPLAY == eglDisplay) {
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    if (EGL_NO_DISPLAY == eglDisplay 
+            || !eglInitialize(eglDisplay, nullptr, nullptr)) {
+        std::cout << "Could not initialize EGL display!" << std::endl;
+        std::exit(-1);
+    }
+
+    display = eglDisplay;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint numConfigs = 0;
+
+    if (!eglChooseConfig(eglDisplay, configAttribs, &config, 1, &numConfigs)
+            || numConfigs < 1) {
+        std::cout << "No suitable EGL config found!" << std::endl;
+        std::exit(-1);
+    }
+
+    // the surface is never drawn to, it only exists because not
+    // every EGL implementation supports EGL_KHR_surfaceless_context
+
+    const EGLint surfaceAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+
+    surface = eglCreatePbufferSurface(eglDisplay, config, surfaceAttribs);
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "EGL does not support desktop OpenGL!" << std::endl;
+        std::exit(-1);
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    context = eglCreateContext(
+            eglDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+
+    if (EGL_NO_CONTEXT == context) {
+        std::cout << "Could not create EGL context!" << std::endl;
+        std::exit(-1);
+    }
+
+    if (!eglMakeCurrent(eglDisplay, surface, surface, context)) {
+        std::cout << "Could not make EGL context current!" << std::endl;
+        std::exit(-1);
+    }
+#else
+    std::cout << "Headless mode is not available, "
+              << "SpatzSim was built without EGL support!" << std::endl;
+    std::exit(-1);
+#endif
+}
+
+HeadlessContext::~HeadlessContext() {
+
+#ifdef SPATZSIM_WITH_EGL
+    if (nullptr == display) {
+        return;
+    }
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+    if (nullptr != context) {
+        eglDestroyContext(display, context);
+    }
+    if (nullptr != surface) {
+        eglDestroySurface(display, surface);
+    }
+
+    eglTerminate(display);
+#endif
+}
@@ -0,0 +1,35 @@
+#ifndef INC_2019_HEADLESSCONTEXT_H
+#define INC_2019_HEADLESSCONTEXT_H
+
+/*
+ * Provides an OpenGL context without any window or display server.
+ *
+ * The context is created through EGL on the surfaceless Mesa platform
+ * (e.g. llvmpipe on render nodes without a display). If that platform
+ * is not available the default EGL display is used instead. As nothing
+ * is ever presented on screen, all rendering must go into framebuffer
+ * objects.
+ *
+ * The EGL handles are stored as opaque pointers, so that including this
+ * header does not pull the (X11 polluted) EGL headers into everything.
+ */
+class HeadlessContext {
+
+    void* display = nullptr;
+    void* surface = nullptr;
+    void* context = nullptr;
+
+public:
+
+    /*
+     * Creates and makes current a new context if enable is set.
+     * Otherwise nothing is done and the object stays empty.
+     */
+    explicit HeadlessContext(bool enable);
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+};
+
+#endif
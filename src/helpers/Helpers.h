@@ -1,18 +1,26 @@
 #include "Camera.h"
 #include "Capture.h"
+#include "ChannelRecorder.h"
+#include "ChannelReplayer.h"
 #include "CinematicCamera.h"
 #include "Clock.h"
 #include "FollowCamera.h"
 #include "FpsCamera.h"
 #include "FrameBuffer.h"
+#include "HeadlessContext.h"
+#include "LatencyHistogram.h"
 #include "Model.h"
 #include "PointLight.h"
 #include "Pose.h"
+#include "Profiler.h"
 #include "Id.h"
 #include "Input.h"
 #include "ScreenQuad.h"
 #include "Shader.h"
 #include "ShaderProgram.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
+#include "UniformBuffer.h"
 
 /*
  * This header file can be used as an include shortcut.
@@ -1,12 +1,14 @@
 #include "helpers/Id.h"
 
+#include <atomic>
+
 uint64_t getId() {
 
     /*
      * This has space for 18446744073709552615 IDs.
      * That should be enough.
      */
-    static uint64_t last_id = 1;
+    static std::atomic<uint64_t> last_id{1};
 
     return ++last_id;
 }
@@ -9,6 +9,7 @@
 
 /*
  * Returns ids in the range of [1, 2^64-1].
+ * Can be called from multiple threads.
  */
 uint64_t getId();
 
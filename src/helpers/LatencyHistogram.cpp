@@ -0,0 +1,103 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr double LatencyHistogram::MIN_LATENCY;
+constexpr size_t LatencyHistogram::BINS_PER_DECADE;
+constexpr size_t LatencyHistogram::DECADES;
+constexpr size_t LatencyHistogram::BIN_COUNT;
+
+LatencyHistogram::LatencyHistogram(std::string name)
+    : name{name}
+    , bins(BIN_COUNT, 0) {
+}
+
+void LatencyHistogram::add(double latency) {
+
+    // clocks of different processes may disagree by a tiny bit
+
+    latency = std::max(latency, 0.0);
+
+    double position = std::log10(latency / MIN_LATENCY) * BINS_PER_DECADE;
+
+    size_t bin = 0;
+
+    if (position > 0) {
+        bin = std::min((size_t)position, BIN_COUNT - 1);
+    }
+
+    bins[bin]++;
+
+    if (count == 0) {
+        min = latency;
+        max = latency;
+    } else {
+        min = std::min(min, latency);
+        max = std::max(max, latency);
+    }
+
+    count++;
+    sum += latency;
+}
+
+void LatencyHistogram::reset() {
+
+    std::fill(bins.begin(), bins.end(), 0);
+
+    count = 0;
+    sum = 0;
+    min = 0;
+    max = 0;
+}
+
+double LatencyHistogram::getBinStart(size_t bin) {
+
+    return MIN_LATENCY * std::pow(10.0, (double)bin / BINS_PER_DECADE);
+}
+
+double LatencyHistogram::getMean() const {
+
+    if (count == 0) {
+        return 0;
+    }
+
+    return sum / count;
+}
+
+double LatencyHistogram::getPercentile(double fraction) const {
+
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)std::ceil(fraction * count);
+    uint64_t counted = 0;
+
+    for (size_t i = 0; i < BIN_COUNT; i++) {
+
+        counted += bins[i];
+
+        if (counted >= rank) {
+            // the bin edge can not be more exact than the real extremes
+            return std::min(std::max(getBinStart(i + 1), min), max);
+        }
+    }
+
+    return max;
+}
+
+ChannelLatency::ChannelLatency(std::string name)
+    : name{name} {
+}
+
+void ChannelLatency::reset() {
+
+    readback.reset();
+    publish.reset();
+    acquire.reset();
+    total.reset();
+
+    published = 0;
+    dropped = 0;
+}
@@ -0,0 +1,96 @@
+#ifndef INC_2019_LATENCYHISTOGRAM_H
+#define INC_2019_LATENCYHISTOGRAM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Counts latencies (in milliseconds) in logarithmic bins, so that
+ * both sub millisecond transfers and stalls of whole seconds can be
+ * told apart. Latencies below the first or above the last bin are
+ * counted in the first or last bin. Exact minimum, maximum and sum
+ * are kept besides the bins, percentiles are estimated from the bins.
+ */
+class LatencyHistogram {
+
+public:
+
+    static constexpr double MIN_LATENCY = 0.01;
+    static constexpr size_t BINS_PER_DECADE = 8;
+    static constexpr size_t DECADES = 6;
+    static constexpr size_t BIN_COUNT = BINS_PER_DECADE * DECADES;
+
+    std::string name;
+
+    std::vector<uint64_t> bins;
+
+    uint64_t count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+
+    explicit LatencyHistogram(std::string name);
+
+    void add(double latency);
+    void reset();
+
+    /*
+     * The lower edge of a bin, the upper edge is
+     * the lower edge of the next bin.
+     */
+    static double getBinStart(size_t bin);
+
+    double getMean() const;
+
+    /*
+     * The upper edge of the bin containing the given
+     * fraction (0 to 1) of all latencies.
+     */
+    double getPercentile(double fraction) const;
+};
+
+/*
+ * The latencies of one shared memory channel, all in milliseconds.
+ * The render time is the time the image was handed to the gpu for
+ * readback, the publish time the time the buffer was unlocked by the
+ * writer and the acquire time the time a reader locked the buffer.
+ */
+struct ChannelLatency {
+
+    std::string name;
+
+    /*
+     * From render to the readback being complete.
+     */
+    LatencyHistogram readback{"readback"};
+
+    /*
+     * From render to publish.
+     */
+    LatencyHistogram publish{"publish"};
+
+    /*
+     * From publish to acquire.
+     */
+    LatencyHistogram acquire{"acquire"};
+
+    /*
+     * From render to acquire, the age of an image when
+     * the consumer gets it.
+     */
+    LatencyHistogram total{"total"};
+
+    /*
+     * Published messages and those that were overwritten
+     * without being read by anybody.
+     */
+    uint64_t published = 0;
+    uint64_t dropped = 0;
+
+    explicit ChannelLatency(std::string name);
+
+    void reset();
+};
+
+#endif
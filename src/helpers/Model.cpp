@@ -1,6 +1,13 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <unordered_map>
 
 #include "Model.h"
+#include "ShaderProgram.h"
 
 #include "Storage.h"
 
@@ -11,17 +18,22 @@ Model::Model(GLenum storageType) : storageType(storageType) {
 
     glGenVertexArrays(1, &vaoId);
     glGenBuffers(1, &vboId);
+    glGenBuffers(1, &eboId);
+    glGenBuffers(1, &materialUboId);
 }
 
 Model::Model(const Model& model) {
 
     glGenVertexArrays(1, &vaoId);
     glGenBuffers(1, &vboId);
+    glGenBuffers(1, &eboId);
+    glGenBuffers(1, &materialUboId);
 
     storageType = model.storageType;
     subModels = model.subModels;
     material = model.material;
     vertices = model.vertices;
+    indices = model.indices;
     boundingBox = model.boundingBox;
 
     upload();
@@ -34,6 +46,8 @@ Model::Model(std::string path, GLenum storageType) : storageType(storageType) {
 
     glGenVertexArrays(1, &vaoId);
     glGenBuffers(1, &vboId);
+    glGenBuffers(1, &eboId);
+    glGenBuffers(1, &materialUboId);
 
     if (!storage::load(*this, path)) {
         std::cerr << "Could not load model from " << path << std::endl;
@@ -45,6 +59,12 @@ Model::~Model() {
 
     glDeleteVertexArrays(1, &vaoId);
     glDeleteBuffers(1, &vboId);
+    glDeleteBuffers(1, &eboId);
+    glDeleteBuffers(1, &materialUboId);
+
+    if (0 != instanceVboId) {
+        glDeleteBuffers(1, &instanceVboId);
+    }
 }
 
 void Model::updateBoundingBox() {
@@ -102,6 +122,360 @@ void Model::updateBoundingBox() {
     boundingBox.center = bboxMins + boundingBox.size / 2.0f;
 }
 
+/*
+ * Tom Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+ * Greedily picks the next triangle by the score of its vertices,
+ * which is high for vertices in a simulated LRU cache and for
+ * vertices with few remaining triangles.
+ */
+
+const int FORSYTH_CACHE_SIZE = 32;
+
+float getForsythVertexScore(int cachePosition, size_t remainingTriangles) {
+
+    if (0 == remainingTriangles) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // the triangle just drawn, its vertices are always in the
+            // cache, but should not be preferred over the older ones
+            score = 0.75f;
+        } else {
+            float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, 1.5f);
+        }
+    }
+
+    // vertices with few remaining triangles are finished first
+
+    score += 2.0f * std::pow((float)remainingTriangles, -0.5f);
+
+    return score;
+}
+
+std::vector<GLuint> optimizeVertexCache(
+        const std::vector<GLuint>& indices,
+        size_t vertexCount) {
+
+    size_t triangleCount = indices.size() / 3;
+
+    // the remaining triangles of every vertex
+
+    std::vector<size_t> triangleOffsets(vertexCount + 1, 0);
+
+    for (GLuint i : indices) {
+        triangleOffsets[i + 1]++;
+    }
+
+    for (size_t v = 0; v < vertexCount; v++) {
+        triangleOffsets[v + 1] += triangleOffsets[v];
+    }
+
+    std::vector<size_t> vertexTriangles(indices.size());
+    std::vector<size_t> remainingTriangles(vertexCount, 0);
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (size_t c = 0; c < 3; c++) {
+            GLuint v = indices[t * 3 + c];
+            vertexTriangles[triangleOffsets[v] + remainingTriangles[v]++] = t;
+        }
+    }
+
+    std::vector<int> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+
+    for (size_t v = 0; v < vertexCount; v++) {
+        vertexScores[v] = getForsythVertexScore(-1, remainingTriangles[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> triangleAdded(triangleCount, false);
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScores[t] = vertexScores[indices[t * 3]]
+            + vertexScores[indices[t * 3 + 1]]
+            + vertexScores[indices[t * 3 + 2]];
+    }
+
+    std::vector<GLuint> cache;
+    std::vector<GLuint> optimized;
+    optimized.reserve(indices.size());
+
+    size_t nextUnadded = 0;
+
+    while (optimized.size() < indices.size()) {
+
+        // the best triangle touching the cache, if there is none
+        // (at the start or once a part of the mesh is finished)
+        // the first triangle that was not added yet
+
+        size_t best = triangleCount;
+        float bestScore = -1.0f;
+
+        for (GLuint v : cache) {
+            for (size_t i = triangleOffsets[v]; i < triangleOffsets[v + 1]; i++) {
+                size_t t = vertexTriangles[i];
+                if (!triangleAdded[t] && triangleScores[t] > bestScore) {
+                    best = t;
+                    bestScore = triangleScores[t];
+                }
+            }
+        }
+
+        if (best == triangleCount) {
+            while (triangleAdded[nextUnadded]) {
+                nextUnadded++;
+            }
+            best = nextUnadded;
+        }
+
+        triangleAdded[best] = true;
+
+        std::vector<GLuint> newCache;
+
+        for (size_t c = 0; c < 3; c++) {
+
+            GLuint v = indices[best * 3 + c];
+
+            optimized.push_back(v);
+
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                newCache.push_back(v);
+            }
+
+            // the triangle is no longer one of the remaining ones
+
+            size_t begin = triangleOffsets[v];
+            size_t end = begin + remainingTriangles[v];
+
+            for (size_t i = begin; i < end; i++) {
+                if (vertexTriangles[i] == best) {
+                    std::swap(vertexTriangles[i], vertexTriangles[end - 1]);
+                    break;
+                }
+            }
+
+            remainingTriangles[v]--;
+        }
+
+        for (GLuint v : cache) {
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                newCache.push_back(v);
+            }
+        }
+
+        // vertices that fall out of the cache lose their cache bonus
+
+        for (size_t i = 0; i < newCache.size(); i++) {
+
+            GLuint v = newCache[i];
+
+            cachePositions[v] = i < FORSYTH_CACHE_SIZE ? (int)i : -1;
+
+            float score = getForsythVertexScore(cachePositions[v], remainingTriangles[v]);
+            float delta = score - vertexScores[v];
+
+            vertexScores[v] = score;
+
+            for (size_t j = triangleOffsets[v]; j < triangleOffsets[v] + remainingTriangles[v]; j++) {
+                triangleScores[vertexTriangles[j]] += delta;
+            }
+        }
+
+        if (newCache.size() > FORSYTH_CACHE_SIZE) {
+            newCache.resize(FORSYTH_CACHE_SIZE);
+        }
+
+        cache.swap(newCache);
+    }
+
+    return optimized;
+}
+
+/*
+ * Vertices are deduplicated by their exact bytes,
+ * the struct consists of floats only (no padding).
+ */
+struct VertexHash {
+
+    size_t operator()(const Model::Vertex& vertex) const {
+
+        const unsigned char* bytes = (const unsigned char*)&vertex;
+
+        size_t hash = 14695981039346656037ull;
+
+        for (size_t i = 0; i < sizeof(Model::Vertex); i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+
+        return hash;
+    }
+};
+
+struct VertexEqual {
+
+    bool operator()(const Model::Vertex& a, const Model::Vertex& b) const {
+
+        return 0 == std::memcmp(&a, &b, sizeof(Model::Vertex));
+    }
+};
+
+/*
+ * The average cache miss ratio, i.e. the vertex shader runs per triangle
+ * with a fifo post transform cache of the given size. It ranges from 3
+ * (no vertex reused) down to about 0.5 for large regular meshes.
+ */
+
+float getAverageCacheMissRatio(
+        const std::vector<GLuint>& indices,
+        size_t vertexCount,
+        size_t cacheSize = 16) {
+
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+
+    // cacheTimes holds the miss count at which a vertex entered the
+    // fifo, it is still cached if less than cacheSize misses followed
+
+    std::vector<size_t> cacheTimes(vertexCount, 0);
+    size_t misses = 0;
+
+    for (GLuint index : indices) {
+        if (0 == cacheTimes[index] || misses - cacheTimes[index] >= cacheSize) {
+            misses++;
+            cacheTimes[index] = misses;
+        }
+    }
+
+    return (float)misses / (float)(indices.size() / 3);
+}
+
+#ifndef NDEBUG
+
+/*
+ * The triangles in a canonical order, to compare two index lists.
+ */
+
+std::vector<std::array<GLuint, 3>> getSortedTriangles(const std::vector<GLuint>& indices) {
+
+    std::vector<std::array<GLuint, 3>> triangles(indices.size() / 3);
+
+    for (size_t t = 0; t < triangles.size(); t++) {
+
+        const GLuint* corners = &indices[t * 3];
+
+        // rotate the smallest index to the front, which keeps the winding
+
+        size_t rotation = std::min_element(corners, corners + 3) - corners;
+
+        for (size_t c = 0; c < 3; c++) {
+            triangles[t][c] = corners[(rotation + c) % 3];
+        }
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+
+    return triangles;
+}
+
+#endif
+
+void Model::indexVertices() {
+
+    std::unordered_map<Vertex, GLuint, VertexHash, VertexEqual> uniqueIndices;
+
+    std::vector<Vertex> uniqueVertices;
+    std::vector<GLuint> newIndices;
+
+    size_t triangleCount = getTriangleCount();
+
+    newIndices.reserve(triangleCount * 3);
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (size_t c = 0; c < 3; c++) {
+
+            const Vertex& vertex = getTriangleVertex(t, c);
+
+            auto it = uniqueIndices.find(vertex);
+
+            if (it == uniqueIndices.end()) {
+                it = uniqueIndices.emplace(vertex, (GLuint)uniqueVertices.size()).first;
+                uniqueVertices.push_back(vertex);
+            }
+
+            newIndices.push_back(it->second);
+        }
+    }
+
+    std::vector<GLuint> optimizedIndices =
+        optimizeVertexCache(newIndices, uniqueVertices.size());
+
+    bool trianglesKept = true;
+
+#ifndef NDEBUG
+    // the reordering must keep every triangle with its winding,
+    // otherwise the model would be rendered with holes. This sorts
+    // all triangles, thus it is only checked in debug builds.
+
+    trianglesKept = getSortedTriangles(optimizedIndices) == getSortedTriangles(newIndices);
+
+    if (!trianglesKept) {
+        std::cerr << "Vertex cache optimization changed the triangles of a model, "
+                  << "keeping the original order." << std::endl;
+    }
+#endif
+
+    // some exporters already write the triangles in a good order
+
+    if (trianglesKept && getAverageCacheMissRatio(optimizedIndices, uniqueVertices.size())
+            < getAverageCacheMissRatio(newIndices, uniqueVertices.size())) {
+        newIndices.swap(optimizedIndices);
+    }
+
+    // the vertices are stored in the order they are first used,
+    // which helps the caches in front of the vertex shader
+
+    std::vector<GLuint> remapping(uniqueVertices.size(), (GLuint)-1);
+
+    vertices.clear();
+    vertices.reserve(uniqueVertices.size());
+
+    for (GLuint& index : newIndices) {
+
+        if ((GLuint)-1 == remapping[index]) {
+            remapping[index] = (GLuint)vertices.size();
+            vertices.push_back(uniqueVertices[index]);
+        }
+
+        index = remapping[index];
+    }
+
+    indices.swap(newIndices);
+}
+
+size_t Model::getTriangleCount() const {
+
+    if (indices.empty()) {
+        return vertices.size() / 3;
+    }
+
+    return indices.size() / 3;
+}
+
+const Model::Vertex& Model::getTriangleVertex(size_t triangle, size_t corner) const {
+
+    if (indices.empty()) {
+        return vertices[triangle * 3 + corner];
+    }
+
+    return vertices[indices[triangle * 3 + corner]];
+}
+
 void Model::upload(GLuint positionLocation,
                    GLuint normalLocation,
                    GLuint texCoordLocation) {
@@ -115,6 +489,15 @@ void Model::upload(GLuint positionLocation,
         vertices.data(),
         storageType);
 
+    // the element buffer binding is part of the vertex array state
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboId);
+    glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER,
+        indices.size() * sizeof(GLuint),
+        indices.data(),
+        storageType);
+
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(
         positionLocation,
@@ -149,41 +532,161 @@ void Model::upload(GLuint positionLocation,
     }
 }
 
-void Model::renderMaterialAndVertices(GLuint shaderProgramId) {
+void Model::renderMaterial() {
 
     // phong coefficients for ambient, diffuse and specular shading
-    GLint kaLocation = glGetUniformLocation(shaderProgramId, "ka");
-    glUniform3f(kaLocation, material.ka.x, material.ka.y, material.ka.z);
+    // and the specular exponent, the material is usually constant,
+    // but some models change their color before every draw call
+
+    if (!materialUploaded
+            || uploadedMaterial.ka != material.ka
+            || uploadedMaterial.kd != material.kd
+            || uploadedMaterial.ks != material.ks
+            || uploadedMaterial.ns != material.ns) {
+
+        uploadedMaterial.ka = material.ka;
+        uploadedMaterial.kd = material.kd;
+        uploadedMaterial.ks = material.ks;
+        uploadedMaterial.ns = material.ns;
+        uploadedMaterial.padding0 = 0;
+        uploadedMaterial.padding1 = 0;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, materialUboId);
+        glBufferData(
+            GL_UNIFORM_BUFFER,
+            sizeof(MaterialBlock),
+            &uploadedMaterial,
+            GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        materialUploaded = true;
+    }
 
-    GLint kdLocation = glGetUniformLocation(shaderProgramId, "kd");
-    glUniform3f(kdLocation, material.kd.x, material.kd.y, material.kd.z);
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, materialUboId);
+}
 
-    GLint ksLocation = glGetUniformLocation(shaderProgramId, "ks");
-    glUniform3f(ksLocation, material.ks.x, material.ks.y, material.ks.z);
+void Model::renderMaterialAndVertices() {
 
-    // specular exponent
-    GLint nsLocation = glGetUniformLocation(shaderProgramId, "ns");
-    glUniform1f(nsLocation, material.ns);
+    renderMaterial();
 
     glBindVertexArray(vaoId);
-    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+
+    if (indices.empty()) {
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+    } else {
+        glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
+    }
+
     glBindVertexArray(0);
 }
 
+void Model::renderMaterialAndVerticesInstanced(
+        GLuint instanceBufferId,
+        GLsizei instanceCount) {
+
+    renderMaterial();
+
+    glBindVertexArray(vaoId);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+
+    // matrices are passed as one vec4 (or vec3) attribute per column
+
+    for (GLuint i = 0; i < 4; i++) {
+        glEnableVertexAttribArray(instanceModelLocation + i);
+        glVertexAttribPointer(
+            instanceModelLocation + i,
+            4,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(Instance),
+            (const void*)(offsetof(Instance, modelMatrix) + i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(instanceModelLocation + i, 1);
+    }
+
+    for (GLuint i = 0; i < 3; i++) {
+        glEnableVertexAttribArray(instanceNormalLocation + i);
+        glVertexAttribPointer(
+            instanceNormalLocation + i,
+            3,
+            GL_FLOAT,
+            GL_FALSE,
+            sizeof(Instance),
+            (const void*)(offsetof(Instance, normalMatrix) + i * sizeof(glm::vec3)));
+        glVertexAttribDivisor(instanceNormalLocation + i, 1);
+    }
+
+    if (indices.empty()) {
+        glDrawArraysInstanced(
+                GL_TRIANGLES, 0, (GLsizei)vertices.size(), instanceCount);
+    } else {
+        glDrawElementsInstanced(
+                GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0, instanceCount);
+    }
+
+    // the vertex array may also be rendered without instances
+
+    for (GLuint i = 0; i < 4; i++) {
+        glDisableVertexAttribArray(instanceModelLocation + i);
+    }
+
+    for (GLuint i = 0; i < 3; i++) {
+        glDisableVertexAttribArray(instanceNormalLocation + i);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void Model::render(GLuint shaderProgramId, glm::mat4 modelMatrix) {
 
-    GLint modelLocation = glGetUniformLocation(shaderProgramId, "model");
-    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &modelMatrix[0][0]);
+    const ShaderProgram::Uniforms& uniforms = ShaderProgram::getUniforms(shaderProgramId);
+
+    glUniformMatrix4fv(uniforms.model, 1, GL_FALSE, &modelMatrix[0][0]);
 
     glm::mat3 normalMat =
         glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
-    GLint normalMatLocation =
-        glGetUniformLocation(shaderProgramId, "normalMat");
-    glUniformMatrix3fv(normalMatLocation, 1, GL_FALSE, &normalMat[0][0]);
+    glUniformMatrix3fv(uniforms.normalMat, 1, GL_FALSE, &normalMat[0][0]);
 
-    renderMaterialAndVertices(shaderProgramId);
+    renderMaterialAndVertices();
 
     for (Model& m : subModels) {
-        m.renderMaterialAndVertices(shaderProgramId);
+        m.renderMaterialAndVertices();
+    }
+}
+
+void Model::renderInstanced(
+        GLuint shaderProgramId,
+        const std::vector<Instance>& instances) {
+
+    if (instances.empty()) {
+        return;
     }
+
+    if (0 == instanceVboId) {
+        glGenBuffers(1, &instanceVboId);
+    }
+
+    // the buffer is orphaned, so that the draw calls of the previous
+    // view can still read the old instances without stalling
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVboId);
+    glBufferData(
+        GL_ARRAY_BUFFER,
+        instances.size() * sizeof(Instance),
+        instances.data(),
+        GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLint instancedLocation = ShaderProgram::getUniforms(shaderProgramId).instanced;
+    glUniform1i(instancedLocation, true);
+
+    renderMaterialAndVerticesInstanced(
+            instanceVboId, (GLsizei)instances.size());
+
+    for (Model& m : subModels) {
+        m.renderMaterialAndVerticesInstanced(
+                instanceVboId, (GLsizei)instances.size());
+    }
+
+    glUniform1i(instancedLocation, false);
 }
@@ -13,8 +13,35 @@ class Model {
 
     GLuint vaoId;
     GLuint vboId;
+    GLuint eboId;
 
-    void renderMaterialAndVertices(GLuint shaderProgramId);
+    /*
+     * The material as "Material" uniform block, it is only written
+     * again when the material was changed since the last upload.
+     */
+    GLuint materialUboId;
+
+    struct MaterialBlock {
+        glm::vec3 ka;
+        float padding0;
+        glm::vec3 kd;
+        float padding1;
+        glm::vec3 ks;
+        float ns;
+    } uploadedMaterial;
+
+    bool materialUploaded = false;
+
+    /*
+     * Holds the instances of renderInstanced, created on first use.
+     */
+    GLuint instanceVboId = 0;
+
+    void renderMaterial();
+    void renderMaterialAndVertices();
+    void renderMaterialAndVerticesInstanced(
+            GLuint instanceBufferId,
+            GLsizei instanceCount);
 
 public:
 
@@ -36,6 +63,12 @@ public:
     };
     std::vector<Vertex> vertices;
 
+    /*
+     * Three indices into vertices per triangle. If empty, the
+     * vertices are drawn as they are, three per triangle.
+     */
+    std::vector<GLuint> indices;
+
     struct Material {
         std::string name;
         glm::vec3 ka;    
@@ -59,11 +92,49 @@ public:
 
     void updateBoundingBox();
 
+    /*
+     * Turns the triangles given by vertices (and indices, if any)
+     * into unique vertices and indices. The triangles are reordered
+     * for the post transform vertex cache of the gpu (Forsyth's
+     * algorithm), unless their original order has fewer cache misses,
+     * the vertices in the order of their first use.
+     * Sub models are not changed.
+     */
+    void indexVertices();
+
+    /*
+     * Work with and without indices.
+     */
+    size_t getTriangleCount() const;
+    const Vertex& getTriangleVertex(size_t triangle, size_t corner) const;
+
     void upload(GLuint positionLocation = 0,
                 GLuint normalLocation = 1,
                 GLuint texCoordLocation = 2);
 
     void render(GLuint shaderProgramId, glm::mat4 modelMatrix);
+
+    /*
+     * The per instance data of renderInstanced, passed to the vertex
+     * shader as attributes (model matrix at locations 3 to 6, normal
+     * matrix at locations 7 to 9) instead of the uniforms.
+     */
+    struct Instance {
+        glm::mat4 modelMatrix;
+        glm::mat3 normalMatrix;
+    };
+
+    static constexpr GLuint instanceModelLocation = 3;
+    static constexpr GLuint instanceNormalLocation = 7;
+
+    /*
+     * Renders the model (and its sub models) once for every given
+     * instance with one draw call per (sub) model. The shader has to
+     * support the "instanced" uniform, see VertexShader.glsl.
+     */
+    void renderInstanced(
+            GLuint shaderProgramId,
+            const std::vector<Instance>& instances);
 };
 
 #endif
@@ -10,19 +10,14 @@ PointLight::PointLight(float x, float y, float z) : pose(x, y, z) {
     specularColor = glm::vec3(1.0f);
 }
 
-void PointLight::render(GLuint shaderProgramId) {
+void PointLight::render(UniformBuffer& lightUniformBuffer) {
 
-    GLuint lightPositionLocation =
-        glGetUniformLocation(shaderProgramId, "lightPosition");
-    GLuint ambientColorLocation = 
-        glGetUniformLocation(shaderProgramId, "ia");
-    GLuint diffuseColorLocation = 
-        glGetUniformLocation(shaderProgramId, "id");
-    GLuint specularColorLocation = 
-        glGetUniformLocation(shaderProgramId, "is");
+    UniformBlock block{};
 
-    glUniform3f(lightPositionLocation, pose.position.x, pose.position.y, pose.position.z);
-    glUniform3fv(ambientColorLocation, 1, &ambientColor[0]);
-    glUniform3fv(diffuseColorLocation, 1, &diffuseColor[0]);
-    glUniform3fv(specularColorLocation, 1, &specularColor[0]);
+    block.lightPosition = pose.position;
+    block.ia = ambientColor;
+    block.id = diffuseColor;
+    block.is = specularColor;
+
+    lightUniformBuffer.update(&block);
 }
@@ -9,6 +9,7 @@
 
 #include "Pose.h"
 #include "Id.h"
+#include "UniformBuffer.h"
 
 class PointLight {
 
@@ -24,9 +25,24 @@ public:
     glm::vec3 specularColor;
 
     /*
-     * Activates this point light for rendering.
+     * The std140 layout of the "Light" uniform block.
      */
-    void render(GLuint shaderProgramId);
+    struct UniformBlock {
+        glm::vec3 lightPosition;
+        float padding0;
+        glm::vec3 ia;
+        float padding1;
+        glm::vec3 id;
+        float padding2;
+        glm::vec3 is;
+        float padding3;
+    };
+
+    /*
+     * Activates this point light for rendering, by writing
+     * it to the light uniform buffer.
+     */
+    void render(UniformBuffer& lightUniformBuffer);
 };
 
 #endif
@@ -158,3 +158,13 @@ Pose Pose::transform(Pose other) {
 
     return pose;
 }
+
+Pose Pose::mix(Pose other, float factor) {
+
+    Pose pose;
+    pose.position = glm::mix(position, other.position, factor);
+    pose.rotation = glm::slerp(rotation, other.rotation, factor);
+    pose.scale = glm::mix(scale, other.scale, factor);
+
+    return pose;
+}
@@ -36,6 +36,13 @@ struct Pose {
     glm::mat4 getInverseMatrix();
 
     Pose transform(Pose other);
+
+    /*
+     * Linearly interpolates position and scale and spherically
+     * interpolates the rotation. A factor of 0 returns this pose,
+     * a factor of 1 returns the other pose.
+     */
+    Pose mix(Pose other, float factor);
 };
 
 #endif
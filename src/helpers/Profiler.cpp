@@ -0,0 +1,154 @@
+#include "Profiler.h"
+
+Profiler::Phase::Phase(std::string name, bool gpu)
+    : name{name}
+    , gpu{gpu}
+    , cpuTimes(HISTORY_SIZE, 0.0f)
+    , gpuTimes(HISTORY_SIZE, 0.0f) {
+}
+
+Profiler::Scope::Scope(Profiler& profiler, size_t phase)
+    : profiler{profiler}
+    , phase{phase}
+    , active{profiler.enabled} {
+
+    if (!active) {
+        return;
+    }
+
+    if (profiler.phases[phase].gpu) {
+        query = profiler.beginGpu(phase);
+    }
+
+    start = std::chrono::steady_clock::now();
+}
+
+Profiler::Scope::~Scope() {
+
+    stop();
+}
+
+void Profiler::Scope::stop() {
+
+    if (!active) {
+        return;
+    }
+
+    active = false;
+
+    std::chrono::duration<double, std::milli> time =
+        std::chrono::steady_clock::now() - start;
+
+    profiler.addCpuTime(phase, time.count());
+
+    if (profiler.phases[phase].gpu) {
+        profiler.endGpu(query);
+    }
+}
+
+Profiler::Profiler(std::vector<Phase> phases)
+    : phases{phases}
+    , frameCpuTimes(phases.size(), 0.0) {
+}
+
+Profiler::~Profiler() {
+
+    for (QuerySlot& slot : querySlots) {
+        if (!slot.queries.empty()) {
+            glDeleteQueries((GLsizei)slot.queries.size(), slot.queries.data());
+        }
+    }
+}
+
+void Profiler::endFrame() {
+
+    if (!enabled) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (size_t i = 0; i < phases.size(); i++) {
+            phases[i].cpuTimes[cpuHistoryIndex] = (float)frameCpuTimes[i];
+            frameCpuTimes[i] = 0.0;
+        }
+    }
+
+    cpuHistoryIndex = (cpuHistoryIndex + 1) % HISTORY_SIZE;
+
+    // the oldest slot is reused for the next frame, so its
+    // results have to be collected now (or never)
+
+    querySlotIndex = (querySlotIndex + 1) % QUERY_FRAMES;
+    collectGpuTimes(querySlots[querySlotIndex]);
+}
+
+size_t Profiler::beginGpu(size_t phase) {
+
+    QuerySlot& slot = querySlots[querySlotIndex];
+
+    size_t query = slot.queryPhases.size();
+
+    if (slot.queries.size() < 2 * (query + 1)) {
+        slot.queries.resize(2 * (query + 1));
+        glGenQueries(2, &slot.queries[2 * query]);
+    }
+
+    slot.queryPhases.push_back(phase);
+
+    glQueryCounter(slot.queries[2 * query], GL_TIMESTAMP);
+
+    return query;
+}
+
+void Profiler::endGpu(size_t query) {
+
+    glQueryCounter(querySlots[querySlotIndex].queries[2 * query + 1], GL_TIMESTAMP);
+}
+
+void Profiler::addCpuTime(size_t phase, double time) {
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    frameCpuTimes[phase] += time;
+}
+
+void Profiler::collectGpuTimes(QuerySlot& slot) {
+
+    if (slot.queryPhases.empty()) {
+        return;
+    }
+
+    // queries finish in order, if the last one is not available
+    // the results are dropped instead of waiting for them
+
+    GLint available = 0;
+    glGetQueryObjectiv(
+            slot.queries[2 * slot.queryPhases.size() - 1],
+            GL_QUERY_RESULT_AVAILABLE,
+            &available);
+
+    if (available) {
+
+        for (Phase& p : phases) {
+            p.gpuTimes[gpuHistoryIndex] = 0.0f;
+        }
+
+        for (size_t i = 0; i < slot.queryPhases.size(); i++) {
+
+            GLuint64 begin = 0;
+            GLuint64 end = 0;
+
+            glGetQueryObjectui64v(slot.queries[2 * i], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(slot.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+
+            phases[slot.queryPhases[i]].gpuTimes[gpuHistoryIndex] +=
+                (float)(end - begin) / 1000000.0f;
+        }
+
+        gpuHistoryIndex = (gpuHistoryIndex + 1) % HISTORY_SIZE;
+    }
+
+    slot.queryPhases.clear();
+}
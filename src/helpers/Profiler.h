@@ -0,0 +1,129 @@
+#ifndef INC_2019_PROFILER_H
+#define INC_2019_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+#include <GL/glew.h>
+
+/*
+ * Measures how much time is spent in the different phases of a frame.
+ *
+ * The cpu time of a phase is measured with the steady clock, the gpu
+ * time with timestamp queries. Both are summed up over all calls of a
+ * phase during one frame (e.g. the physics update runs several times
+ * per frame) and kept in a rolling history of the last frames.
+ *
+ * Timestamp queries are used instead of elapsed time queries, because
+ * they can be nested. Their results are read a few frames later, when
+ * they are available, so that the profiler never stalls the pipeline.
+ * Thus the gpu history lags the cpu history by some frames.
+ *
+ * Cpu phases may be measured from any thread, gpu phases only
+ * from the thread that owns the OpenGL context.
+ */
+class Profiler {
+
+public:
+
+    static const size_t HISTORY_SIZE = 256;
+
+    /*
+     * The number of frames to wait for the timestamp query results.
+     */
+    static const size_t QUERY_FRAMES = 4;
+
+    struct Phase {
+
+        std::string name;
+
+        /*
+         * Whether gpu time is measured, this requires
+         * the phase to run on the OpenGL thread.
+         */
+        bool gpu;
+
+        /*
+         * The times in milliseconds, the entry of the last
+         * frame is at historyIndex - 1 (wrapping around).
+         */
+        std::vector<float> cpuTimes;
+        std::vector<float> gpuTimes;
+
+        Phase(std::string name, bool gpu);
+    };
+
+    /*
+     * Measures one call of a phase, until this object goes
+     * out of scope or the measurement is stopped explicitly.
+     */
+    class Scope {
+
+        Profiler& profiler;
+        size_t phase;
+        bool active;
+        size_t query = 0;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+
+        Scope(Profiler& profiler, size_t phase);
+        ~Scope();
+
+        void stop();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /*
+     * Nothing is measured unless enabled.
+     */
+    bool enabled = false;
+
+    std::vector<Phase> phases;
+
+    size_t cpuHistoryIndex = 0;
+    size_t gpuHistoryIndex = 0;
+
+    /*
+     * The phases are referenced by their index in the given list.
+     */
+    explicit Profiler(std::vector<Phase> phases);
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /*
+     * Stores the times of the finished frame in the history
+     * and collects the available timestamp query results.
+     */
+    void endFrame();
+
+private:
+
+    struct QuerySlot {
+
+        // the query objects, two per measured call
+        std::vector<GLuint> queries;
+
+        // the phase of each pair of queries in use
+        std::vector<size_t> queryPhases;
+    };
+
+    QuerySlot querySlots[QUERY_FRAMES];
+    size_t querySlotIndex = 0;
+
+    std::mutex mutex;
+    std::vector<double> frameCpuTimes;
+
+    size_t beginGpu(size_t phase);
+    void endGpu(size_t query);
+    void addCpuTime(size_t phase, double time);
+    void collectGpuTimes(QuerySlot& slot);
+};
+
+#endif
@@ -1,6 +1,18 @@
 #include "ShaderProgram.h"
 
 #include <iostream>
+#include <unordered_map>
+
+/*
+ * The uniform locations of all linked programs, by program id.
+ */
+static std::unordered_map<GLuint, ShaderProgram::Uniforms> programUniforms;
+
+/*
+ * Consecutive draw calls usually use the same program.
+ */
+static GLuint lastProgramId = 0;
+static const ShaderProgram::Uniforms* lastUniforms = nullptr;
 
 ShaderProgram::ShaderProgram(GLuint vertexShaderId, GLuint fragShaderId) {
 
@@ -39,6 +51,8 @@ ShaderProgram::ShaderProgram(GLuint vertexShaderId, GLuint fragShaderId) {
 
         std::exit(-1);
 	}
+
+    registerProgram(id);
 }
 
 ShaderProgram::ShaderProgram(Shader vertexShader, Shader fragShader)
@@ -56,4 +70,63 @@ ShaderProgram::ShaderProgram(
 ShaderProgram::~ShaderProgram() {
 
     glDeleteProgram(id);
+
+    programUniforms.erase(id);
+
+    if (lastProgramId == id) {
+        lastProgramId = 0;
+        lastUniforms = nullptr;
+    }
+}
+
+void ShaderProgram::registerProgram(GLuint programId) {
+
+    Uniforms& uniforms = programUniforms[programId];
+
+    uniforms.model = glGetUniformLocation(programId, "model");
+    uniforms.normalMat = glGetUniformLocation(programId, "normalMat");
+    uniforms.billboard = glGetUniformLocation(programId, "billboard");
+    uniforms.instanced = glGetUniformLocation(programId, "instanced");
+    uniforms.lighting = glGetUniformLocation(programId, "lighting");
+    uniforms.time = glGetUniformLocation(programId, "time");
+    uniforms.noise = glGetUniformLocation(programId, "noise");
+    uniforms.tex = glGetUniformLocation(programId, "tex");
+
+    // glsl 330 can not specify the binding points in the shader
+
+    const std::pair<const char*, GLuint> blocks[] = {
+        {"Camera", CAMERA_BLOCK_BINDING},
+        {"Light", LIGHT_BLOCK_BINDING},
+        {"Material", MATERIAL_BLOCK_BINDING},
+    };
+
+    for (const std::pair<const char*, GLuint>& block : blocks) {
+
+        GLuint index = glGetUniformBlockIndex(programId, block.first);
+
+        if (GL_INVALID_INDEX != index) {
+            glUniformBlockBinding(programId, index, block.second);
+        }
+    }
+}
+
+const ShaderProgram::Uniforms& ShaderProgram::getUniforms(GLuint programId) {
+
+    if (lastProgramId == programId && nullptr != lastUniforms) {
+        return *lastUniforms;
+    }
+
+    auto it = programUniforms.find(programId);
+
+    // programs that were not linked by this class are resolved on first use
+
+    if (it == programUniforms.end()) {
+        registerProgram(programId);
+        it = programUniforms.find(programId);
+    }
+
+    lastProgramId = programId;
+    lastUniforms = &it->second;
+
+    return it->second;
 }
@@ -4,17 +4,45 @@
 #include <GL/glew.h>
 
 #include "Shader.h"
+#include "UniformBuffer.h"
 
 class ShaderProgram {
 
 public:
 
+    /*
+     * The locations of the uniforms that are set per draw call,
+     * -1 if the program does not have the uniform. Camera, light
+     * and material are uniform blocks (see UniformBuffer).
+     */
+    struct Uniforms {
+        GLint model = -1;
+        GLint normalMat = -1;
+        GLint billboard = -1;
+        GLint instanced = -1;
+        GLint lighting = -1;
+        GLint time = -1;
+        GLint noise = -1;
+        GLint tex = -1;
+    };
+
     GLuint id;
 
     ShaderProgram(GLuint vertexShaderId, GLuint fragShaderId);
     ShaderProgram(Shader vertexShader, Shader fragShader);
     ShaderProgram(std::string vertexShaderPath, std::string fragShaderPath);
     ~ShaderProgram();
+
+    /*
+     * Returns the uniform locations of the program with the given id.
+     * They are looked up once when the program is linked, instead of
+     * by name on every draw call. Must be called from the OpenGL thread.
+     */
+    static const Uniforms& getUniforms(GLuint programId);
+
+private:
+
+    static void registerProgram(GLuint programId);
 };
 
 #endif
@@ -0,0 +1,83 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount) {
+
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    startCondition.notify_all();
+
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+size_t ThreadPool::getThreadCount() {
+
+    return threads.size();
+}
+
+void ThreadPool::run(size_t count, std::function<void(size_t)> job) {
+
+    if (threads.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    this->job = job;
+    jobCount = count;
+    nextJob = 0;
+    busyThreads = threads.size();
+    generation++;
+
+    startCondition.notify_all();
+
+    doneCondition.wait(lock, [this]{ return busyThreads == 0; });
+}
+
+void ThreadPool::work() {
+
+    uint64_t lastGeneration = 0;
+
+    while (true) {
+
+        std::unique_lock<std::mutex> lock(mutex);
+
+        startCondition.wait(lock, [&]{
+            return stopping || generation != lastGeneration;
+        });
+
+        if (stopping) {
+            return;
+        }
+
+        lastGeneration = generation;
+
+        lock.unlock();
+
+        for (size_t i = nextJob++; i < jobCount; i = nextJob++) {
+            job(i);
+        }
+
+        lock.lock();
+
+        busyThreads--;
+
+        if (busyThreads == 0) {
+            doneCondition.notify_one();
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef INC_2019_THREADPOOL_H
+#define INC_2019_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A fixed set of worker threads that process a batch of jobs.
+ * The jobs are identified by their index and are distributed
+ * dynamically, so that fast workers take over more jobs.
+ */
+class ThreadPool {
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+
+    std::function<void(size_t)> job;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextJob{0};
+
+    // incremented for every batch, wakes up the workers
+    uint64_t generation = 0;
+
+    size_t busyThreads = 0;
+    bool stopping = false;
+
+    void work();
+
+public:
+
+    /*
+     * Without threads the jobs are run on the calling thread.
+     */
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t getThreadCount();
+
+    /*
+     * Calls job(i) for every i in [0, count) and
+     * blocks until all of these calls are finished.
+     */
+    void run(size_t count, std::function<void(size_t)> job);
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef INC_2019_TRIPLEBUFFER_H
+#define INC_2019_TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+/*
+ * A lock-free single producer, single consumer triple buffer.
+ *
+ * The producer always writes into its own buffer and publishes it by
+ * exchanging it with the buffer in the middle. The consumer takes the
+ * middle buffer, if something new was published, and reads from it.
+ * Thus, neither of both ever waits for the other and the consumer
+ * always gets the newest published value. Values that are published
+ * faster than they are consumed are simply overwritten.
+ */
+template <typename T>
+class TripleBuffer {
+
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t NEW_FLAG = 0x4;
+
+    T buffers[3];
+
+    /*
+     * The index of the middle buffer, the NEW_FLAG bit
+     * is set if it was published but not yet consumed.
+     */
+    std::atomic<uint8_t> middle{1};
+
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 2;
+
+public:
+
+    /*
+     * The buffer the producer can write into.
+     */
+    T& getWriteBuffer() {
+        return buffers[writeIndex];
+    }
+
+    /*
+     * Makes the write buffer available to the consumer.
+     */
+    void publish() {
+        writeIndex = middle.exchange(
+                writeIndex | NEW_FLAG, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /*
+     * Swaps in the newest published buffer. Returns
+     * false if nothing new was published since the last call.
+     */
+    bool update() {
+
+        if (!(middle.load(std::memory_order_acquire) & NEW_FLAG)) {
+            return false;
+        }
+
+        readIndex = middle.exchange(
+                readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+
+        return true;
+    }
+
+    /*
+     * The buffer the consumer can read from.
+     */
+    T& getReadBuffer() {
+        return buffers[readIndex];
+    }
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "UniformBuffer.h"
+
+UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size)
+    : binding{binding}
+    , size{size} {
+
+    glGenBuffers(1, &id);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    bind();
+}
+
+UniformBuffer::~UniformBuffer() {
+
+    glDeleteBuffers(1, &id);
+}
+
+void UniformBuffer::update(const void* data) {
+
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::bind() {
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);
+}
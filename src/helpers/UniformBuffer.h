@@ -0,0 +1,48 @@
+#ifndef INC_2019_UNIFORMBUFFER_H
+#define INC_2019_UNIFORMBUFFER_H
+
+#include <GL/glew.h>
+
+/*
+ * The binding points of the uniform blocks shared by all shader
+ * programs. ShaderProgram binds the blocks of these names to them
+ * when the program is linked.
+ */
+enum UniformBlockBinding : GLuint {
+    CAMERA_BLOCK_BINDING = 0,
+    LIGHT_BLOCK_BINDING = 1,
+    MATERIAL_BLOCK_BINDING = 2
+};
+
+/*
+ * A uniform buffer object, bound to the given binding point when it
+ * is created. The data has to follow the std140 layout rules, e.g.
+ * a vec3 is padded to 16 bytes.
+ */
+class UniformBuffer {
+
+public:
+
+    GLuint id = 0;
+    GLuint binding;
+    GLsizeiptr size;
+
+    UniformBuffer(GLuint binding, GLsizeiptr size);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    /*
+     * Replaces the whole content of the buffer.
+     */
+    void update(const void* data);
+
+    /*
+     * Binds the buffer to its binding point again, needed
+     * if another buffer was bound to it in the meantime.
+     */
+    void bind();
+};
+
+#endif
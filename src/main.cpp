@@ -1,5 +1,6 @@
 #include "Loop.h"
 #include "Storage.h"
+#include "helpers/ChannelReplayer.h"
 #include "p-ranav_argparse/argparse.hpp"
 
 int main (int argc, char* argv[]) {
@@ -33,6 +34,75 @@ int main (int argc, char* argv[]) {
         .implicit_value(true)
         .help("start simulator in fullscreen mode");
 
+    parser.add_argument("-l", "--headless")
+        .default_value(false)
+        .implicit_value(true)
+        .help("run without a window, only render and transmit the car sensor images");
+
+    parser.add_argument("-x", "--fast-forward")
+        .default_value(false)
+        .implicit_value(true)
+        .help("simulate as fast as possible, decoupled from the wall clock");
+
+    parser.add_argument("-k", "--lockstep")
+        .default_value(false)
+        .implicit_value(true)
+        .help("wait for the controller to acknowledge every simulation tick");
+
+    parser.add_argument("-t", "--threaded")
+        .default_value(false)
+        .implicit_value(true)
+        .help("run the simulation on a separate thread, independent of the rendering");
+
+    parser.add_argument("-i", "--instance")
+        .nargs(1)
+        .default_value(0)
+        .action([](const std::string& value) { return std::stoi(value); })
+        .help("shared memory instance (0 to 255), to run several simulators on one machine");
+
+    parser.add_argument("--posix-shm")
+        .default_value(false)
+        .implicit_value(true)
+        .help("use POSIX shared memory instead of SysV shared memory");
+
+    parser.add_argument("--huge-pages")
+        .default_value(false)
+        .implicit_value(true)
+        .help("back the POSIX shared memory with huge pages");
+
+    parser.add_argument("--capture-depth")
+        .nargs(1)
+        .default_value(3)
+        .action([](const std::string& value) { return std::stoi(value); })
+        .help("number of camera images in flight between the gpu and the shared memory, at least 2");
+
+    parser.add_argument("--profile")
+        .nargs(1)
+        .default_value(std::string(""))
+        .help("profile every frame and write the profile to the given .csv or .json file on exit");
+
+    parser.add_argument("--record-log")
+        .nargs(1)
+        .default_value(std::string(""))
+        .help("record all shared memory messages to the given file");
+
+    parser.add_argument("--replay")
+        .nargs(1)
+        .default_value(std::string(""))
+        .help("publish the messages recorded in the given file instead of simulating");
+
+    parser.add_argument("--replay-speed")
+        .nargs(1)
+        .default_value(1.0f)
+        .action([](const std::string& value) { return std::stof(value); })
+        .help("speed of the replay relative to the recording, 0 is as fast as possible");
+
+    parser.add_argument("--replay-start")
+        .nargs(1)
+        .default_value(0.0)
+        .action([](const std::string& value) { return std::stod(value); })
+        .help("seconds from the beginning of the recording to start the replay at");
+
     parser.add_argument("-a", "--autotracks")
         .default_value(false)
         .implicit_value(true)
@@ -53,6 +123,11 @@ int main (int argc, char* argv[]) {
         } 
         parser.print_help();
         return 0;
+    } catch (const std::logic_error& err) {
+        // thrown by the conversions of invalid numbers
+        std::cout << "Invalid argument: " << err.what() << "\n" << std::endl;
+        parser.print_help();
+        return -1;
     }
 
     std::string argConfigPath = parser.get<std::string>("-c");
@@ -60,9 +135,33 @@ int main (int argc, char* argv[]) {
     std::string argResourcePath = parser.get<std::string>("-r");
     bool argPauseOnStartup = parser.get<bool>("-p");
     bool argFullscreen = parser.get<bool>("-f");
+    bool argHeadless = parser.get<bool>("-l");
+    bool argFastForward = parser.get<bool>("-x");
+    bool argLockstep = parser.get<bool>("-k");
+    bool argThreaded = parser.get<bool>("-t");
+    int argInstance = parser.get<int>("-i");
+    bool argPosixShm = parser.get<bool>("--posix-shm");
+    bool argHugePages = parser.get<bool>("--huge-pages");
+    int argCaptureDepth = parser.get<int>("--capture-depth");
+    std::string argProfilePath = parser.get<std::string>("--profile");
+    std::string argRecordLogPath = parser.get<std::string>("--record-log");
+    std::string argReplayPath = parser.get<std::string>("--replay");
+    float argReplaySpeed = parser.get<float>("--replay-speed");
+    double argReplayStart = parser.get<double>("--replay-start");
     bool argEnableAutoTracks = parser.get<bool>("-a");
     bool argRecord = parser.get<bool>("-e");
 
+    if (argInstance < 0 || argInstance > CommModule::maxInstance) {
+        std::cerr << "The instance must be between 0 and "
+                  << CommModule::maxInstance << "." << std::endl;
+        return -1;
+    }
+
+    if (argCaptureDepth < 2) {
+        std::cerr << "The capture depth must be at least 2." << std::endl;
+        return -1;
+    }
+
     // Setting up objects, initiating main loop
 
     storage::createXDGSettingsDirectory();
@@ -97,6 +196,42 @@ int main (int argc, char* argv[]) {
         settings.resourcePath = argResourcePath;
     }
     settings.fullscreen = argFullscreen;
+    settings.headless = argHeadless;
+    settings.fastForward = argFastForward;
+    settings.lockstep = argLockstep;
+    settings.threadedSimulation = argThreaded;
+    settings.sharedMemoryInstance = argInstance;
+    settings.posixSharedMemory = argPosixShm;
+    settings.hugePages = argHugePages;
+    settings.captureDepth = argCaptureDepth;
+    settings.profilePath = argProfilePath;
+    settings.recordPath = argRecordLogPath;
+
+    // replaying a log needs neither the scene nor the renderer
+
+    if (!argReplayPath.empty()) {
+        ChannelReplayer replayer(argReplayPath);
+
+        if (!replayer.isOpen()) {
+            return -1;
+        }
+
+        // the log is replayed into the keys of the selected instance
+
+        replayer.replay(
+                argReplaySpeed,
+                argReplayStart,
+                [&settings](int key) {
+                    return CommModule::getInstanceKey(
+                            key, settings.sharedMemoryInstance);
+                },
+                settings.posixSharedMemory
+                    ? SimulatorSHM::BACKEND_POSIX
+                    : SimulatorSHM::BACKEND_SYSV,
+                settings.hugePages);
+
+        return 0;
+    }
 
     Scene scene(settings.configPath);
     scene.paused = argPauseOnStartup;
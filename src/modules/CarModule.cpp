@@ -25,20 +25,11 @@ float CarModule::calcLaserSensorValue(
         Model& itemModel = modelStore.items[it.type];
         glm::mat4 modelMat = it.pose.getMatrix();
 
-        for (unsigned int i = 2 ; i < itemModel.vertices.size() ; i += 3) {
-
-            glm::vec3 vec0 = {
-                itemModel.vertices[i-2].position.x,
-                itemModel.vertices[i-2].position.y,
-                itemModel.vertices[i-2].position.z };
-            glm::vec3 vec1 = {
-                itemModel.vertices[i-1].position.x,
-                itemModel.vertices[i-1].position.y,
-                itemModel.vertices[i-1].position.z };
-            glm::vec3 vec2 = {
-                itemModel.vertices[i].position.x,
-                itemModel.vertices[i].position.y,
-                itemModel.vertices[i].position.z };
+        for (size_t i = 0; i < itemModel.getTriangleCount(); i++) {
+
+            glm::vec3 vec0 = itemModel.getTriangleVertex(i, 0).position;
+            glm::vec3 vec1 = itemModel.getTriangleVertex(i, 1).position;
+            glm::vec3 vec2 = itemModel.getTriangleVertex(i, 2).position;
 
             vec0 = modelMat * glm::vec4(vec0, 1);
             vec1 = modelMat * glm::vec4(vec1, 1);
@@ -220,8 +211,9 @@ void CarModule::updatePosition(Car& car, float deltaTime) {
     car.alphaFront = alpha_front;
     car.alphaRear = alpha_rear;
     car.drivenDistance += std::sqrt(std::pow(dt * dx.x1, 2) + std::pow(dt * dx.x2, 2));
+}
 
-    // user controls ...
+void CarModule::updateManualControl(Car& car) {
 
     // calculate longitudinal velocity
     auto psi = glm::radians(car.modelPose.getEulerAngles().y);
@@ -304,7 +296,7 @@ void CarModule::updateDepthCamera(
     }
 }
 
-void CarModule::updateLaserSensors(
+void CarModule::updateLaserSensor(
         Car& car,
         ModelStore& modelStore,
         std::vector<Scene::Item>& items) {
@@ -312,29 +304,38 @@ void CarModule::updateLaserSensors(
     glm::vec4 laserDirection{-1, 0, 0, 0};
     laserDirection = car.modelPose.getMatrix() * laserDirection;
 
-    glm::vec3 binaryLightSensorWorldPos = car.modelPose.getMatrix() * 
-        glm::vec4(car.binaryLightSensor.pose.position, 1);
-
     glm::vec3 laserSensorWorldPos = car.modelPose.getMatrix() * 
         glm::vec4(car.laserSensor.pose.position, 1);
 
-    car.binaryLightSensor.value = calcLaserSensorValue(
-            binaryLightSensorWorldPos,
+    car.laserSensor.value = calcLaserSensorValue(
+            laserSensorWorldPos,
             laserDirection,
             modelStore,
             items);
+}
 
-    car.binaryLightSensor.triggered =
-        car.binaryLightSensor.value <= car.binaryLightSensor.triggerDistance;
+void CarModule::updateBinaryLightSensor(
+        Car& car,
+        ModelStore& modelStore,
+        std::vector<Scene::Item>& items) {
 
-    car.laserSensor.value = calcLaserSensorValue(
-            laserSensorWorldPos,
+    glm::vec4 laserDirection{-1, 0, 0, 0};
+    laserDirection = car.modelPose.getMatrix() * laserDirection;
+
+    glm::vec3 binaryLightSensorWorldPos = car.modelPose.getMatrix() * 
+        glm::vec4(car.binaryLightSensor.pose.position, 1);
+
+    car.binaryLightSensor.value = calcLaserSensorValue(
+            binaryLightSensorWorldPos,
             laserDirection,
             modelStore,
             items);
+
+    car.binaryLightSensor.triggered =
+        car.binaryLightSensor.value <= car.binaryLightSensor.triggerDistance;
 }
 
-void CarModule::render(GLuint shaderProgramId, Car& car, ModelStore& modelStore) {
+void CarModule::render(GLuint shaderProgramId, Pose& modelPose, ModelStore& modelStore) {
 
-    modelStore.car.render(shaderProgramId, car.modelPose.getMatrix());
+    modelStore.car.render(shaderProgramId, modelPose.getMatrix());
 }
@@ -23,12 +23,22 @@ class CarModule {
         Camera depthCamera;
 
         FrameBuffer frameBuffer{1, 1, 1, GL_RGBA, GL_RGBA};
-        FrameBuffer bayerFrameBuffer{1, 1, 1, GL_RED, GL_RED};
+        FrameBuffer bayerFrameBuffer{1, 1, 1, GL_R8, GL_RED, GL_UNSIGNED_BYTE};
         FrameBuffer depthCameraFrameBuffer{1, 1, 1, GL_RGB32F, GL_RGB};
 
         CarModule();
 
-        void updatePosition(Car& car, float deltaTime);
+        /*
+         * The physics and sensor updates do not depend on the state
+         * of this module (which contains OpenGL objects), so they
+         * can be used without an instance and from any thread.
+         */
+        static void updatePosition(Car& car, float deltaTime);
+
+        /*
+         * Overrides the vesc commands with the arrow keys.
+         */
+        void updateManualControl(Car& car);
 
         void updateMainCamera(
                 Car::MainCamera& carMainCamera,
@@ -38,15 +48,20 @@ class CarModule {
                 Car::DepthCamera& carDepthCamera,
                 Pose& carModelPose);
 
-        void updateLaserSensors(
+        static void updateLaserSensor(
+                Car& car,
+                ModelStore& modelStore,
+                std::vector<Scene::Item>& items);
+
+        static void updateBinaryLightSensor(
                 Car& car,
                 ModelStore& modelStore,
                 std::vector<Scene::Item>& items);
 
-        void render(GLuint shaderProgramId, Car& car, ModelStore& store);
+        void render(GLuint shaderProgramId, Pose& modelPose, ModelStore& store);
 
     private:
-        float calcLaserSensorValue(
+        static float calcLaserSensorValue(
                 glm::vec3 position,
                 glm::vec3 direction,
                 ModelStore& modelStore,
@@ -1,21 +1,62 @@
 #include "CommModule.h"
 
-CommModule::CommModule() :
-    txMainCamera(mainCameraMemId),
-    txDepthCamera(depthCameraMemId),
-    txCarState(carMemId),
-    rxVesc(vescMemId),
-    rxVisual(visualMemId) { 
-
-    initSharedMemory(txMainCamera);
-    initSharedMemory(txDepthCamera);
+CommModule::CommModule(int instance, SimulatorSHM::Backend backend, bool hugePages) :
+    txMainCamera(mainCameraMemId + instance * instanceKeyStride, sizeof(CameraImageHeader)),
+    txDepthCamera(depthCameraMemId + instance * instanceKeyStride, sizeof(CameraImageHeader)),
+    txCarState(carMemId + instance * instanceKeyStride),
+    rxVesc(vescMemId + instance * instanceKeyStride),
+    rxVisual(visualMemId + instance * instanceKeyStride),
+    txDirectory(directoryMemId + instance * instanceKeyStride),
+    backend(backend) { 
+
+    latencies.emplace_back("main_camera");
+    latencies.emplace_back("depth_camera");
+    latencies.emplace_back("car_state");
+    latencies.emplace_back("vesc");
+    latencies.emplace_back("visualization");
+
+    txMainCamera.setBackend(backend, hugePages);
+    txDepthCamera.setBackend(backend, hugePages);
+    txCarState.setBackend(backend, hugePages);
+    rxVesc.setBackend(backend, hugePages);
+    rxVisual.setBackend(backend, hugePages);
+    txDirectory.setBackend(backend, hugePages);
+
+    // the camera channels are created with the first image,
+    // because their size depends on the camera configuration
+
     initSharedMemory(txCarState);
     initSharedMemory(rxVesc);
     initSharedMemory(rxVisual);
+    initSharedMemory(txDirectory);
+
+    transmitDirectory();
 }
 
 CommModule::~CommModule() {
 
+    // the POSIX segments written by the simulator are removed, the
+    // controller notices that and attaches again after a restart
+
+    if (SimulatorSHM::BACKEND_POSIX == backend) {
+        txMainCamera.destroy();
+        txDepthCamera.destroy();
+        txCarState.destroy();
+        txDirectory.destroy();
+    }
+}
+
+int CommModule::getInstanceKey(int key, int instance) {
+
+    // not a key of any instance, e.g. from a foreign log
+
+    if (key < mainCameraMemId) {
+        return key;
+    }
+
+    int channelKey = mainCameraMemId + (key - mainCameraMemId) % instanceKeyStride;
+
+    return channelKey + instance * instanceKeyStride;
 }
 
 template<typename T>
@@ -27,32 +68,197 @@ void CommModule::initSharedMemory(SimulatorSHM::SHMComm<T>& mem) {
     }
 }
 
-void CommModule::transmitMainCamera(
-        Car& car, 
-        Capture& mainCameraCapture, 
-        GLuint mainCameraFramebufferId) {
+template<typename T>
+void CommModule::addChannelInfo(
+        ChannelDirectory& directory,
+        const char* name,
+        SimulatorSHM::SHMComm<T>& channel,
+        uint32_t schemaVersion,
+        ChannelDirection direction) {
+
+    if (directory.channelCount >= ChannelDirectory::maxChannels) {
+        return;
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, mainCameraFramebufferId);
+    ChannelInfo& info = directory.channels[directory.channelCount++];
 
-    // download image from opengl to shared memory buffer
+    std::memset(&info, 0, sizeof(ChannelInfo));
+    std::strncpy(info.name, name, sizeof(info.name) - 1);
 
-    MainCameraImage* obj = txMainCamera.lock(SimulatorSHM::WRITE_OVERWRITE_OLDEST); 
+    info.key = channel.key();
+    info.schemaVersion = schemaVersion;
+    info.direction = direction;
+    info.bufferCount = channel.bufferCount();
+    info.bufferSize = channel.size();
+}
 
-    if (obj != nullptr) {
+void CommModule::transmitDirectory() {
+
+    ChannelDirectory* obj = txDirectory.lock(SimulatorSHM::WRITE_OVERWRITE_OLDEST);
 
-        obj->imageWidth = car.mainCamera.imageWidth;
-        obj->imageHeight = car.mainCamera.imageHeight;
+    if (obj == nullptr) {
+        return;
+    }
 
-        mainCameraCapture.capture(
-                (GLubyte*)obj->buffer,
-                car.mainCamera.imageWidth,
-                car.mainCamera.imageHeight,
-                1,
-                GL_RED,
-                GL_UNSIGNED_BYTE);
+    std::memset(obj, 0, sizeof(ChannelDirectory));
 
-        txMainCamera.unlock(obj);
-    } 
+    obj->version = 1;
+    obj->backend = backend;
+
+    // the camera channels only exist once the first image was sent
+
+    if (0 != mainCameraLayout.bufferCount) {
+        addChannelInfo(*obj, "main_camera", txMainCamera,
+                cameraImageVersion, CHANNEL_FROM_SIMULATOR);
+    }
+
+    if (0 != depthCameraLayout.bufferCount) {
+        addChannelInfo(*obj, "depth_camera", txDepthCamera,
+                cameraImageVersion, CHANNEL_FROM_SIMULATOR);
+    }
+
+    addChannelInfo(*obj, "car_state", txCarState,
+            carStateVersion, CHANNEL_FROM_SIMULATOR);
+    addChannelInfo(*obj, "vesc", rxVesc,
+            vescVersion, CHANNEL_TO_SIMULATOR);
+    addChannelInfo(*obj, "visualization", rxVisual,
+            visualizationVersion, CHANNEL_TO_SIMULATOR);
+
+    txDirectory.unlock(obj);
+}
+
+void CommModule::startRecording(std::string path) {
+
+    std::vector<ChannelRecorder::Channel> channels(5);
+
+    auto describe = [&](RecordedChannel index, const char* name, int key, uint32_t version) {
+        ChannelRecorder::Channel& channel = channels[index];
+        std::memset(&channel, 0, sizeof(channel));
+        std::strncpy(channel.name, name, sizeof(channel.name) - 1);
+        channel.key = key;
+        channel.schemaVersion = version;
+    };
+
+    describe(RECORD_MAIN_CAMERA, "main_camera", txMainCamera.key(), cameraImageVersion);
+    describe(RECORD_DEPTH_CAMERA, "depth_camera", txDepthCamera.key(), cameraImageVersion);
+    describe(RECORD_CAR_STATE, "car_state", txCarState.key(), carStateVersion);
+    describe(RECORD_VESC, "vesc", rxVesc.key(), vescVersion);
+    describe(RECORD_VISUALIZATION, "visualization", rxVisual.key(), visualizationVersion);
+
+    recorder.reset(new ChannelRecorder(path, channels));
+}
+
+void CommModule::record(RecordedChannel channel, const void* data, size_t size) {
+
+    if (recorder) {
+        recorder->record(channel, data, size);
+    }
+}
+
+template<typename T>
+void CommModule::measureOverwritten(
+        ChannelLatency& latency,
+        SimulatorSHM::SHMComm<T>& channel,
+        double renderTime) {
+
+    double publishTime;
+    double acquireTime;
+
+    if (!channel.lockedStamps(publishTime, acquireTime)) {
+        return;
+    }
+
+    if (0 == acquireTime) {
+        latency.dropped++;
+        return;
+    }
+
+    latency.acquire.add((acquireTime - publishTime) * 1000.0);
+
+    if (0 != renderTime) {
+        latency.total.add((acquireTime - renderTime) * 1000.0);
+    }
+}
+
+template<typename T>
+void CommModule::measureAcquired(
+        ChannelLatency& latency,
+        SimulatorSHM::SHMComm<T>& channel) {
+
+    double publishTime;
+    double acquireTime;
+
+    if (channel.lockedStamps(publishTime, acquireTime)) {
+        latency.acquire.add((acquireTime - publishTime) * 1000.0);
+        latency.published++;
+    }
+}
+
+void CommModule::configureCameraChannel(
+        SimulatorSHM::SHMComm<CameraImageHeader>& channel,
+        CameraImageHeader& layout,
+        int width,
+        int height,
+        int bytesPerPixel,
+        PixelFormat format) {
+
+    if (layout.width == (uint32_t)width
+            && layout.height == (uint32_t)height
+            && layout.format == format
+            && layout.bufferCount != 0) {
+        return;
+    }
+
+    layout.width = width;
+    layout.height = height;
+    layout.stride = width * bytesPerPixel;
+    layout.format = format;
+    layout.bufferCount = NBUFFERS;
+
+    // the sequence keeps counting, so consumers see the resize as a gap
+
+    size_t size = sizeof(CameraImageHeader) + (size_t)layout.stride * layout.height;
+
+    if (!channel.create(size, layout.bufferCount)) {
+        std::cout << "Shared memory init failed!" << std::endl;
+        std::exit(-1);
+    }
+
+    transmitDirectory();
+}
+
+void CommModule::transmitMainCamera(
+        Car& car, 
+        Capture& mainCameraCapture, 
+        GLuint mainCameraFramebufferId,
+        uint64_t tick,
+        double simulationTime,
+        Pose& cameraPose) {
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mainCameraFramebufferId);
+
+    configureCameraChannel(
+            txMainCamera,
+            mainCameraLayout,
+            car.mainCamera.imageWidth,
+            car.mainCamera.imageHeight,
+            1,
+            PIXEL_FORMAT_BAYER8);
+
+    mainCameraCapture.read(
+            car.mainCamera.imageWidth,
+            car.mainCamera.imageHeight,
+            1,
+            GL_RED,
+            GL_UNSIGNED_BYTE,
+            mainCameraLayout.sequence + 1);
+
+    addPendingImage(
+            pendingMainCameraImages,
+            mainCameraLayout,
+            tick,
+            simulationTime,
+            cameraPose);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
@@ -60,39 +266,155 @@ void CommModule::transmitMainCamera(
 void CommModule::transmitDepthCamera(
         Car& car, 
         Capture& depthCameraCapture, 
-        GLuint depthCameraFramebufferId) {
+        GLuint depthCameraFramebufferId,
+        uint64_t tick,
+        double simulationTime,
+        Pose& cameraPose) {
 
     glBindFramebuffer(GL_FRAMEBUFFER, depthCameraFramebufferId);
 
-    // download image from opengl to shared memory buffer
+    configureCameraChannel(
+            txDepthCamera,
+            depthCameraLayout,
+            car.depthCamera.depthImageWidth,
+            car.depthCamera.depthImageHeight,
+            4 * 3,
+            PIXEL_FORMAT_RGB32F);
+
+    depthCameraCapture.read(
+            car.depthCamera.depthImageWidth,
+            car.depthCamera.depthImageHeight,
+            4 * 3,
+            GL_RGB,
+            GL_FLOAT,
+            depthCameraLayout.sequence + 1);
+
+    addPendingImage(
+            pendingDepthCameraImages,
+            depthCameraLayout,
+            tick,
+            simulationTime,
+            cameraPose);
 
-    DepthCameraImage* obj = txDepthCamera.lock(SimulatorSHM::WRITE_OVERWRITE_OLDEST); 
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static double getMonotonicTime() {
+
+    // steady_clock is CLOCK_MONOTONIC on linux
+
+    return std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CommModule::addPendingImage(
+        std::deque<CameraImageHeader>& pendingImages,
+        CameraImageHeader& layout,
+        uint64_t tick,
+        double simulationTime,
+        Pose& cameraPose) {
+
+    layout.sequence++;
+
+    CameraImageHeader image = layout;
+
+    image.tick = tick;
+    image.simulationTime = simulationTime;
+    image.renderTime = getMonotonicTime();
+    image.captureTime = 0;
+
+    image.position[0] = cameraPose.position.x;
+    image.position[1] = cameraPose.position.y;
+    image.position[2] = cameraPose.position.z;
+
+    image.rotation[0] = cameraPose.rotation.x;
+    image.rotation[1] = cameraPose.rotation.y;
+    image.rotation[2] = cameraPose.rotation.z;
+    image.rotation[3] = cameraPose.rotation.w;
+
+    pendingImages.push_back(image);
+
+    // the capture drops images if the gpu falls behind,
+    // usually their headers are removed once a newer one is sent
+
+    while (pendingImages.size() > 16) {
+        pendingImages.pop_front();
+    }
+}
+
+void CommModule::transmitCompletedImage(
+        SimulatorSHM::SHMComm<CameraImageHeader>& channel,
+        std::deque<CameraImageHeader>& pendingImages,
+        Capture& capture,
+        RecordedChannel recordedChannel) {
+
+    if (pendingImages.empty() || !capture.isAvailable()) {
+        return;
+    }
+
+    // download the newest complete image from opengl to shared memory buffer
+
+    CameraImageHeader* obj = channel.lock(SimulatorSHM::WRITE_OVERWRITE_OLDEST); 
 
     if (obj != nullptr) {
 
-        obj->imageWidth = car.depthCamera.depthImageWidth;
-        obj->imageHeight = car.depthCamera.depthImageHeight;
+        ChannelLatency& latency = latencies[recordedChannel];
+
+        // the header still belongs to the image that is overwritten
+
+        measureOverwritten(latency, channel, obj->renderTime);
+
+        uint64_t sequence = 0;
 
-        depthCameraCapture.capture(
-                (GLubyte*)obj->buffer,
-                car.depthCamera.depthImageWidth,
-                car.depthCamera.depthImageHeight,
-                4 * 3,
-                GL_RGB,
-                GL_FLOAT);
+        capture.retrieve((GLubyte*)(obj + 1), sequence);
 
-        txDepthCamera.unlock(obj);
+        while (pendingImages.size() > 1 && pendingImages.front().sequence < sequence) {
+            pendingImages.pop_front();
+        }
+
+        *obj = pendingImages.front();
+        obj->captureTime = getMonotonicTime();
+
+        pendingImages.pop_front();
+
+        double renderTime = obj->renderTime;
+
+        latency.readback.add((obj->captureTime - renderTime) * 1000.0);
+
+        record(recordedChannel, obj, channel.size());
+
+        channel.unlock(obj);
+
+        latency.publish.add((getMonotonicTime() - renderTime) * 1000.0);
+        latency.published++;
     } 
+}
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+void CommModule::transmitCompletedImages(
+        Capture& mainCameraCapture,
+        Capture& depthCameraCapture) {
+
+    transmitCompletedImage(
+            txMainCamera,
+            pendingMainCameraImages,
+            mainCameraCapture,
+            RECORD_MAIN_CAMERA);
+
+    transmitCompletedImage(
+            txDepthCamera,
+            pendingDepthCameraImages,
+            depthCameraCapture,
+            RECORD_DEPTH_CAMERA);
 }
 
-void CommModule::transmitCar(Car& car, bool paused, double simulationTime) {
+void CommModule::transmitCar(Car& car, bool paused, double simulationTime, uint64_t tick) {
 
     CarState* obj = txCarState.lock(SimulatorSHM::WRITE_OVERWRITE_OLDEST); 
 
     if (obj != nullptr) {
 
+        measureOverwritten(latencies[RECORD_CAR_STATE], txCarState, 0);
+
         obj->x = car.simulatorState.x1;
         obj->y = car.simulatorState.x2;
         obj->psi = car.simulatorState.psi;
@@ -110,6 +432,8 @@ void CommModule::transmitCar(Car& car, bool paused, double simulationTime) {
         obj->laserSensorValue = car.laserSensor.value;
         obj->binaryLightSensorTriggered = car.binaryLightSensor.triggered;
         obj->paused = paused;
+        obj->tick = tick;
+        carStateTick = tick;
 
         /*
          * TODO: sucks
@@ -120,22 +444,62 @@ void CommModule::transmitCar(Car& car, bool paused, double simulationTime) {
             }
         }
 
+        record(RECORD_CAR_STATE, obj, sizeof(CarState));
+
         txCarState.unlock(obj);
+
+        latencies[RECORD_CAR_STATE].published++;
     }
 }
 
-void CommModule::receiveVesc(Car::Vesc& vesc) {
+void CommModule::receiveVesc(Car::Vesc& vesc, double simulationTime) {
 
-    Vesc* obj = rxVesc.lock(SimulatorSHM::READ_NEWEST);
+    // read the whole queue, oldest first
 
-    if (obj != nullptr) {
-        vescFailCounter = 0;
+    bool received = false;
 
-        vesc.velocity = obj->velocity;
-        vesc.steeringAngleFront = obj->steeringAngleFront;
-        vesc.steeringAngleRear = obj->steeringAngleRear;
+    while (Vesc* obj = rxVesc.lock(SimulatorSHM::READ_OLDEST)) {
+
+        measureAcquired(latencies[RECORD_VESC], rxVesc);
+
+        Vesc command = *obj;
 
         rxVesc.unlock(obj);
+
+        record(RECORD_VESC, &command, sizeof(Vesc));
+
+        received = true;
+
+        // commands with equal time keep the order they were written in
+
+        auto position = pendingVescCommands.end();
+
+        while (position != pendingVescCommands.begin()
+                && std::prev(position)->time > command.time) {
+            position--;
+        }
+
+        pendingVescCommands.insert(position, command);
+    }
+
+    bool applied = false;
+
+    while (!pendingVescCommands.empty()
+            && pendingVescCommands.front().time <= simulationTime) {
+
+        Vesc& command = pendingVescCommands.front();
+
+        vesc.velocity = command.velocity;
+        vesc.steeringAngleFront = command.steeringAngleFront;
+        vesc.steeringAngleRear = command.steeringAngleRear;
+
+        pendingVescCommands.pop_front();
+
+        applied = true;
+    }
+
+    if (received || applied || !pendingVescCommands.empty()) {
+        vescFailCounter = 0;
     } else if (vescFailCounter == 100) {
         vesc.velocity = 0.0f;
         vesc.steeringAngleFront = 0.0f;
@@ -146,12 +510,63 @@ void CommModule::receiveVesc(Car::Vesc& vesc) {
     }
 }
 
+bool CommModule::receiveVescLockstep(Car::Vesc& vesc, float timeout) {
+
+    // nothing was transmitted yet, so there is nothing to acknowledge
+
+    if (0 == carStateTick) {
+        return true;
+    }
+
+    auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::microseconds((long)(timeout * 1000000.0f));
+
+    do {
+        Vesc* obj = rxVesc.lock(SimulatorSHM::READ_NEWEST);
+
+        if (obj != nullptr) {
+
+            measureAcquired(latencies[RECORD_VESC], rxVesc);
+
+            bool acknowledged = obj->tick >= carStateTick;
+
+            if (acknowledged) {
+                record(RECORD_VESC, obj, sizeof(Vesc));
+
+                vesc.velocity = obj->velocity;
+                vesc.steeringAngleFront = obj->steeringAngleFront;
+                vesc.steeringAngleRear = obj->steeringAngleRear;
+            }
+
+            rxVesc.unlock(obj);
+
+            if (acknowledged) {
+                return true;
+            }
+        }
+
+        // sleep until the client publishes the next vesc message
+
+        float remaining = std::chrono::duration<float>(
+                deadline - std::chrono::steady_clock::now()).count();
+
+        if (remaining <= 0 || !rxVesc.waitNewer(remaining)) {
+            break;
+        }
+
+    } while (std::chrono::steady_clock::now() < deadline);
+
+    return false;
+}
+
 void CommModule::receiveVisualization(Scene::Visualization& vis) {
 
     Visualization* obj = rxVisual.lock(SimulatorSHM::READ_NEWEST);
 
     if (obj != nullptr) {
 
+        measureAcquired(latencies[RECORD_VISUALIZATION], rxVisual);
+
         vis.trajectoryPoints.clear();
 
         for (int i = 0; i < 128; i++) {
@@ -159,6 +574,8 @@ void CommModule::receiveVisualization(Scene::Visualization& vis) {
             vis.trajectoryPoints.emplace_back(pos.y, pos.x);
         }
 
+        record(RECORD_VISUALIZATION, obj, sizeof(Visualization));
+
         rxVisual.unlock(obj);
     } 
 }
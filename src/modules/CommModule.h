@@ -2,10 +2,16 @@
 #define INC_2019_COMMMODULE_H
 
 #include <errno.h>
+#include <deque>
+#include <memory>
 #include <cstring>
+#include <chrono>
+#include <thread>
 
 #include "scene/Scene.h"
 #include "helpers/Capture.h"
+#include "helpers/ChannelRecorder.h"
+#include "helpers/LatencyHistogram.h"
 #include "sharedmem/shmcomm.h"
 
 class CommModule {
@@ -15,28 +21,90 @@ class CommModule {
     static constexpr int vescMemId = 428771;
     static constexpr int depthCameraMemId = 428772;
     static constexpr int visualMemId = 428773;
+    static constexpr int directoryMemId = 428774;
+
+    /*
+     * The keys of instance n are the ids above plus n times this,
+     * so that several simulators can run on one machine.
+     */
+    static constexpr int instanceKeyStride = 16;
+
+    /*
+     * Must be incremented whenever the layout of the message changes,
+     * so that clients can detect that they are out of date.
+     */
+    static constexpr uint32_t cameraImageVersion = 1;
+    static constexpr uint32_t carStateVersion = 1;
+    static constexpr uint32_t vescVersion = 1;
+    static constexpr uint32_t visualizationVersion = 1;
+
+    enum PixelFormat : uint32_t {
+        PIXEL_FORMAT_BAYER8 = 0,
+        PIXEL_FORMAT_RGB32F = 1
+    };
 
-    struct MainCameraImage {
+    /*
+     * Every buffer of a camera channel starts with this header,
+     * directly followed by the image (height rows of stride bytes,
+     * bottom row first, as read from OpenGL). The size of the
+     * segment is derived from the configured camera resolution,
+     * consumers attach without knowing it and read the layout from
+     * here. If the resolution changes the segment is replaced and
+     * the old one is invalidated.
+     *
+     * The remaining fields describe when and from where the image
+     * was taken, so that it can be matched to the car state. Wall
+     * clock times are seconds of the monotonic clock (as returned by
+     * clock_gettime(CLOCK_MONOTONIC, ...)), which is the same for
+     * all processes on the machine.
+     */
+    struct CameraImageHeader {
+
+        uint32_t width;
+        uint32_t height;
 
         /*
-         * Assuming 2064x1544 Bayer 8 (one byte per pixel) as the maximum
-         * possible image size otherwise ... welp, not good ...
+         * Bytes per image row.
          */
-        unsigned char buffer[2064*1544];
+        uint32_t stride;
 
-        int imageWidth;
-        int imageHeight;
-    };
+        uint32_t format;
+        uint32_t bufferCount;
+
+        uint32_t reserved;
+
+        /*
+         * Consecutive number of the images of this channel,
+         * a gap means that images were dropped.
+         */
+        uint64_t sequence;
 
-    struct DepthCameraImage {
+        /*
+         * The simulation tick the image was rendered at, the car
+         * state of the same tick carries the same number.
+         */
+        uint64_t tick;
 
         /*
-         * Here we assume 640x480 to be the maximum possible depth image size of one camera.
+         * The simulation time the image was rendered at. In between
+         * ticks the scene is interpolated, so this can lie between
+         * the times of two car states.
          */
-        float buffer[640*2*480*3];
+        double simulationTime;
 
-        int imageWidth;
-        int imageHeight;
+        /*
+         * The wall clock time the readback of the image started
+         * and the time it was complete and copied to this buffer.
+         */
+        double renderTime;
+        double captureTime;
+
+        /*
+         * The pose of the camera in world coordinates at render
+         * time, the rotation as quaternion (x, y, z, w).
+         */
+        float position[3];
+        float rotation[4];
     };
 
     struct CarState {
@@ -68,12 +136,37 @@ class CommModule {
         float laserSensorValue;
 
         bool binaryLightSensorTriggered;
+
+        /*
+         * The simulation tick of this car state, used for lockstep
+         * and to match the camera images to the car state.
+         */
+        uint64_t tick;
     };
 
+    /*
+     * The vesc channel is a queue: every message is read, in the order
+     * the messages were written. Controllers should write with
+     * WRITE_NO_OVERWRITE, so that no command is lost.
+     */
     struct Vesc {
 
         double velocity;
         double steeringAngleFront, steeringAngleRear;
+
+        /*
+         * The simulation time the command should be applied at. The
+         * command takes effect in the first tick that reaches this
+         * time. Zero (or any time in the past) applies the command
+         * in the next tick.
+         */
+        double time;
+
+        /*
+         * In lockstep mode the controller must set this to the tick
+         * of the car state the command was computed for.
+         */
+        uint64_t tick;
     };
 
     struct Visualization {
@@ -81,34 +174,233 @@ class CommModule {
         glm::vec2 trajectoryPoints[128];
     };
 
+    enum ChannelDirection : uint32_t {
+        CHANNEL_FROM_SIMULATOR = 0,
+        CHANNEL_TO_SIMULATOR = 1
+    };
+
+    struct ChannelInfo {
+
+        /*
+         * Null terminated, e.g. "car_state".
+         */
+        char name[32];
+
+        int32_t key;
+        uint32_t schemaVersion;
+        uint32_t direction;
+
+        /*
+         * The number of buffers and the size of one buffer in the
+         * segment, for camera channels including the image.
+         */
+        uint32_t bufferCount;
+        uint64_t bufferSize;
+    };
+
+    /*
+     * The directory lists all channels of this simulator instance. It
+     * is a channel itself, at a key that never changes (except by the
+     * instance), and is written again whenever a channel changes, e.g.
+     * because the camera resolution was changed. Clients read the
+     * newest one, find their channels by name and check the schema
+     * version and size before attaching.
+     */
+    struct ChannelDirectory {
+
+        static constexpr uint32_t maxChannels = 16;
+
+        /*
+         * Version of the directory layout itself.
+         */
+        uint32_t version;
+
+        uint32_t backend;
+        uint32_t channelCount;
+
+        uint32_t reserved;
+
+        ChannelInfo channels[maxChannels];
+    };
+
+    /*
+     * The index of the channels in the recorded log.
+     */
+    enum RecordedChannel : uint32_t {
+        RECORD_MAIN_CAMERA,
+        RECORD_DEPTH_CAMERA,
+        RECORD_CAR_STATE,
+        RECORD_VESC,
+        RECORD_VISUALIZATION
+    };
+
+    std::unique_ptr<ChannelRecorder> recorder;
+
     int vescFailCounter = 0;
 
-    SimulatorSHM::SHMComm<MainCameraImage> txMainCamera; 
-    SimulatorSHM::SHMComm<DepthCameraImage> txDepthCamera; 
+    /*
+     * Received commands that are not yet due, ordered by time.
+     */
+    std::deque<Vesc> pendingVescCommands;
+
+    uint64_t carStateTick = 0;
+
+    CameraImageHeader mainCameraLayout{};
+    CameraImageHeader depthCameraLayout{};
+
+    /*
+     * The headers of the images whose readback is in flight.
+     */
+    std::deque<CameraImageHeader> pendingMainCameraImages;
+    std::deque<CameraImageHeader> pendingDepthCameraImages;
+
+    SimulatorSHM::SHMComm<CameraImageHeader> txMainCamera; 
+    SimulatorSHM::SHMComm<CameraImageHeader> txDepthCamera; 
     SimulatorSHM::SHMComm<CarState> txCarState; 
     SimulatorSHM::SHMComm<Vesc> rxVesc; 
     SimulatorSHM::SHMComm<Visualization> rxVisual; 
+    SimulatorSHM::SHMComm<ChannelDirectory> txDirectory; 
+
+    SimulatorSHM::Backend backend;
 
     template<typename T>
     void initSharedMemory(SimulatorSHM::SHMComm<T>& mem);
 
+    template<typename T>
+    void addChannelInfo(
+            ChannelDirectory& directory,
+            const char* name,
+            SimulatorSHM::SHMComm<T>& channel,
+            uint32_t schemaVersion,
+            ChannelDirection direction);
+
+    void transmitDirectory();
+
+    void record(RecordedChannel channel, const void* data, size_t size);
+
+    /*
+     * Adds the latencies of the message that was in the buffer
+     * just locked for writing, before it is overwritten.
+     */
+    template<typename T>
+    void measureOverwritten(
+            ChannelLatency& latency,
+            SimulatorSHM::SHMComm<T>& channel,
+            double renderTime);
+
+    /*
+     * Adds the latency of the message just locked for reading.
+     */
+    template<typename T>
+    void measureAcquired(
+            ChannelLatency& latency,
+            SimulatorSHM::SHMComm<T>& channel);
+
+    /*
+     * (Re)creates the camera channel if the layout changed.
+     */
+    void configureCameraChannel(
+            SimulatorSHM::SHMComm<CameraImageHeader>& channel,
+            CameraImageHeader& layout,
+            int width,
+            int height,
+            int bytesPerPixel,
+            PixelFormat format);
+
+    void addPendingImage(
+            std::deque<CameraImageHeader>& pendingImages,
+            CameraImageHeader& layout,
+            uint64_t tick,
+            double simulationTime,
+            Pose& cameraPose);
+
+    void transmitCompletedImage(
+            SimulatorSHM::SHMComm<CameraImageHeader>& channel,
+            std::deque<CameraImageHeader>& pendingImages,
+            Capture& capture,
+            RecordedChannel recordedChannel);
+
 public:
 
-    CommModule();
+    /*
+     * Instances range from 0 to this, which keeps the keys in a small
+     * range above the ids, away from the keys of unrelated programs.
+     */
+    static constexpr int maxInstance = 255;
+
+    /*
+     * The latencies of the channels, in the order of RecordedChannel.
+     * For the channels written by the simulator the acquire time is
+     * that of the controller, it is seen when the buffer is reused.
+     */
+    std::vector<ChannelLatency> latencies;
+
+    /*
+     * The instance selects the set of shared memory keys, the
+     * controller must use the keys of the same instance and
+     * the same backend.
+     */
+    explicit CommModule(
+            int instance = 0,
+            SimulatorSHM::Backend backend = SimulatorSHM::BACKEND_SYSV,
+            bool hugePages = false);
     ~CommModule();
 
+    /*
+     * Returns the key of the same channel as the given
+     * key (of any instance) for the given instance.
+     */
+    static int getInstanceKey(int key, int instance);
+
+    /*
+     * Records every message sent or received from now on
+     * to the log at the given path, see ChannelRecorder.
+     */
+    void startRecording(std::string path);
+
+    /*
+     * Start reading the camera image rendered at the given tick and
+     * time from the given camera pose, it is transmitted by
+     * transmitCompletedImages once the transfer is complete.
+     */
     void transmitMainCamera(
             Car& car, 
             Capture& mainCameraCapture, 
-            GLuint mainCameraFramebufferId);
+            GLuint mainCameraFramebufferId,
+            uint64_t tick,
+            double simulationTime,
+            Pose& cameraPose);
 
     void transmitDepthCamera(
             Car& car, 
             Capture& depthCameraCapture, 
-            GLuint depthCameraFramebufferId);
-
-    void transmitCar(Car& car, bool paused, double simulationTime);
-    void receiveVesc(Car::Vesc& car);
+            GLuint depthCameraFramebufferId,
+            uint64_t tick,
+            double simulationTime,
+            Pose& cameraPose);
+
+    /*
+     * Transmits the newest camera images whose transfer is complete,
+     * should be called every frame. Never waits for the gpu, unless
+     * the captures are synchronous.
+     */
+    void transmitCompletedImages(
+            Capture& mainCameraCapture,
+            Capture& depthCameraCapture);
+
+    void transmitCar(Car& car, bool paused, double simulationTime, uint64_t tick);
+    /*
+     * Reads all queued vesc commands and applies the newest one that
+     * is due at the given simulation time.
+     */
+    void receiveVesc(Car::Vesc& car, double simulationTime);
+
+    /*
+     * Waits until the controller acknowledged the last transmitted
+     * car state with a vesc command. Returns false if this did not
+     * happen within timeout seconds.
+     */
+    bool receiveVescLockstep(Car::Vesc& vesc, float timeout);
     void receiveVisualization(Scene::Visualization& vis);
 };
 
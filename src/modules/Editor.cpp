@@ -321,21 +321,11 @@ void Editor::setAutoAlign(bool autoAlign, const Tracks& tracks) {
     updateMarkers(tracks);
 }
 
-void Editor::renderScene(GLuint shaderProgramId, Model& groundModel, const Tracks& tracks, float groundSize) {
+void Editor::captureTrackModels(const Tracks& tracks,
+        std::vector<RenderState::TrackModel>& renderTrackModels) {
 
-    // render ground
-    glm::mat4 groundModelMat(1.0f);
-    groundModelMat = glm::scale(groundModelMat, glm::vec3(groundSize, 1.0f, groundSize));
-
-    glm::vec3 groundColor{0.05, 0.05, 0.05};
+    renderTrackModels.clear();
 
-    groundModel.material.ka = groundColor;
-    groundModel.material.kd = groundColor;
-    groundModel.material.ks = groundColor;
-
-    groundModel.render(shaderProgramId, groundModelMat);
-
-    // render tracks
     std::set<std::shared_ptr<TrackBase>> ts;
     for (std::shared_ptr<ControlPoint> const& cp : tracks.getTracks()) {
         for (std::shared_ptr<TrackBase> const& t : cp->tracks) {
@@ -397,13 +387,38 @@ void Editor::renderScene(GLuint shaderProgramId, Model& groundModel, const Track
         }
 
         if (dragState.dragging) {
-            getDraggedTrackModel(track)->render(shaderProgramId, getDraggedTrackModelMat(track));
+            renderTrackModels.push_back({
+                    getDraggedTrackModel(track),
+                    getDraggedTrackModelMat(track)});
         } else {
-            trackModels[track]->render(shaderProgramId, trackModelMats[track]);
+            renderTrackModels.push_back({
+                    trackModels[track],
+                    trackModelMats[track]});
         }
     }
 }
 
+void Editor::renderScene(GLuint shaderProgramId, Model& groundModel,
+        const std::vector<RenderState::TrackModel>& renderTrackModels, float groundSize) {
+
+    // render ground
+    glm::mat4 groundModelMat(1.0f);
+    groundModelMat = glm::scale(groundModelMat, glm::vec3(groundSize, 1.0f, groundSize));
+
+    glm::vec3 groundColor{0.05, 0.05, 0.05};
+
+    groundModel.material.ka = groundColor;
+    groundModel.material.kd = groundColor;
+    groundModel.material.ks = groundColor;
+
+    groundModel.render(shaderProgramId, groundModelMat);
+
+    // render tracks
+    for (const RenderState::TrackModel& trackModel : renderTrackModels) {
+        trackModel.model->render(shaderProgramId, trackModel.modelMat);
+    }
+}
+
 void Editor::renderMarkers(GLuint shaderProgramId, const Tracks& tracks, const glm::vec3 cameraPosition) {
 
     // render control points
@@ -11,6 +11,7 @@
 #include "helpers/Helpers.h"
 
 #include "scene/Tracks.h"
+#include "scene/RenderState.h"
 
 class Editor {
 
@@ -102,7 +103,13 @@ public:
     void setTrackMode(TrackMode trackMode, const Tracks& tracks);
     void setAutoAlign(bool autoAlign, const Tracks& tracks);
 
-    void renderScene(GLuint shaderProgramId, Model& groundModel, const Tracks& tracks, float groundSize);
+    // collect the track models and matrices for rendering without the scene,
+    // models of new tracks are uploaded, thus this needs the gl context
+    void captureTrackModels(const Tracks& tracks,
+            std::vector<RenderState::TrackModel>& renderTrackModels);
+
+    void renderScene(GLuint shaderProgramId, Model& groundModel,
+            const std::vector<RenderState::TrackModel>& renderTrackModels, float groundSize);
     void renderMarkers(GLuint shaderProgramId, const Tracks& tracks, const glm::vec3 cameraPosition);
 
 private:
@@ -31,6 +31,12 @@ GuiModule::GuiModule(GLFWwindow* window, std::string scenePath) {
     openedFilePath = fs::path(scenePath);
     selectedFilePath = scenePath;
 
+    // without a window (headless mode) there is nothing to draw into
+
+    if (nullptr == window) {
+        return;
+    }
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
 
@@ -42,6 +48,10 @@ GuiModule::GuiModule(GLFWwindow* window, std::string scenePath) {
 
 GuiModule::~GuiModule() {
 
+    if (nullptr == window) {
+        return;
+    }
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -109,6 +119,8 @@ void GuiModule::renderRootWindow(Scene& scene, Settings& settings) {
             ImGui::MenuItem("Scene", NULL, &showSceneWindow);
             ImGui::MenuItem("Settings", NULL, &showSettingsWindow);
             ImGui::MenuItem("Rules", NULL, &showRuleWindow);
+            ImGui::MenuItem("Profiler", NULL, &showProfilerWindow);
+            ImGui::MenuItem("Latency", NULL, &showLatencyWindow);
             ImGui::MenuItem("Help", NULL, &showHelpWindow);
             ImGui::MenuItem("About", NULL, &showAboutWindow);
 
@@ -581,6 +593,12 @@ void GuiModule::renderPoseGui(Pose& pose) {
     }
 }
 
+void GuiModule::renderSensorTimingGui(Car::SensorTiming& timing) {
+
+    ImGui::DragFloat("rate", &timing.rate, 1.0f, 0.0f, 1000.0f);
+    ImGui::DragFloat("phase", &timing.phase, 0.001f, 0.0f, 1.0f);
+}
+
 void GuiModule::renderErrorDialog(std::string& msg) {
 
     if (!msg.empty()) { 
@@ -687,6 +705,17 @@ void GuiModule::renderSceneWindow(Scene& scene) {
 
                 ImGui::DragFloat("noise", &scene.car.mainCamera.noise, 0.01f, 0.0f, 1.0f);
 
+                renderSensorTimingGui(scene.car.mainCamera.timing);
+
+                ImGui::TreePop();
+            }
+
+            if (ImGui::TreeNode("Depth Camera")) {
+
+                renderPoseGui(scene.car.depthCamera.pose);
+
+                renderSensorTimingGui(scene.car.depthCamera.timing);
+
                 ImGui::TreePop();
             }
 
@@ -694,6 +723,7 @@ void GuiModule::renderSceneWindow(Scene& scene) {
 
                 renderPoseGui(scene.car.laserSensor.pose);
                 ImGui::InputFloat("value", &scene.car.laserSensor.value);
+                renderSensorTimingGui(scene.car.laserSensor.timing);
 
                 ImGui::TreePop();
             }
@@ -705,6 +735,7 @@ void GuiModule::renderSceneWindow(Scene& scene) {
                         &scene.car.binaryLightSensor.triggerDistance);
                 ImGui::Checkbox("triggered",
                         &scene.car.binaryLightSensor.triggered);
+                renderSensorTimingGui(scene.car.binaryLightSensor.timing);
 
                 ImGui::TreePop();
             }
@@ -1016,6 +1047,177 @@ void GuiModule::renderHelpWindow() {
     }
 }
 
+void GuiModule::renderProfilerWindow(Profiler& profiler, bool alwaysEnabled) {
+
+    // measuring costs time as well, so only do it when looking at
+    // it, unless the profile is written on exit
+
+    profiler.enabled = showProfilerWindow || alwaysEnabled;
+
+    if (showProfilerWindow) {
+
+        ImGui::Begin("Profiler", &showProfilerWindow,
+                ImGuiWindowFlags_AlwaysAutoResize);
+
+        ImGui::Text("Time per frame in ms, gpu times lag by %d frames",
+                (int)Profiler::QUERY_FRAMES);
+
+        for (Profiler::Phase& phase : profiler.phases) {
+
+            ImGui::PushID(phase.name.c_str());
+
+            size_t last = (profiler.cpuHistoryIndex
+                    + Profiler::HISTORY_SIZE - 1) % Profiler::HISTORY_SIZE;
+
+            std::string overlay = "cpu " + std::to_string(phase.cpuTimes[last]);
+
+            ImGui::PlotHistogram(
+                    phase.name.c_str(),
+                    phase.cpuTimes.data(),
+                    (int)phase.cpuTimes.size(),
+                    (int)profiler.cpuHistoryIndex,
+                    overlay.c_str(),
+                    0.0f,
+                    FLT_MAX,
+                    ImVec2(300, 40));
+
+            if (phase.gpu) {
+
+                last = (profiler.gpuHistoryIndex
+                        + Profiler::HISTORY_SIZE - 1) % Profiler::HISTORY_SIZE;
+
+                overlay = "gpu " + std::to_string(phase.gpuTimes[last]);
+
+                ImGui::PlotHistogram(
+                        "",
+                        phase.gpuTimes.data(),
+                        (int)phase.gpuTimes.size(),
+                        (int)profiler.gpuHistoryIndex,
+                        overlay.c_str(),
+                        0.0f,
+                        FLT_MAX,
+                        ImVec2(300, 40));
+            }
+
+            ImGui::PopID();
+        }
+
+        ImGui::Separator();
+
+        char pathInputBuf[256];
+        strncpy(pathInputBuf, profilerDumpPath.c_str(), sizeof(pathInputBuf) - 1);
+        pathInputBuf[sizeof(pathInputBuf) - 1] = '\0';
+        ImGui::InputText("path", pathInputBuf, IM_ARRAYSIZE(pathInputBuf));
+        profilerDumpPath = std::string(pathInputBuf);
+
+        if (ImGui::Button("Save CSV")) {
+            if (!storage::saveCsv(profiler, profilerDumpPath + ".csv")) {
+                errorMessage = "Could not write " + profilerDumpPath + ".csv!";
+            }
+        }
+
+        ImGui::SameLine();
+
+        if (ImGui::Button("Save JSON")) {
+            if (!storage::save(profiler, profilerDumpPath + ".json")) {
+                errorMessage = "Could not write " + profilerDumpPath + ".json!";
+            }
+        }
+
+        renderErrorDialog(errorMessage);
+
+        ImGui::End();
+    }
+}
+
+void renderLatencyHistogram(LatencyHistogram& histogram) {
+
+    if (histogram.count == 0) {
+        return;
+    }
+
+    std::vector<float> bins(histogram.bins.begin(), histogram.bins.end());
+
+    char overlay[128];
+    snprintf(overlay, sizeof(overlay),
+            "mean %.2f p50 %.2f p99 %.2f max %.2f",
+            histogram.getMean(),
+            histogram.getPercentile(0.5),
+            histogram.getPercentile(0.99),
+            histogram.max);
+
+    ImGui::PlotHistogram(
+            histogram.name.c_str(),
+            bins.data(),
+            (int)bins.size(),
+            0,
+            overlay,
+            0.0f,
+            FLT_MAX,
+            ImVec2(300, 40));
+}
+
+void GuiModule::renderLatencyWindow(std::vector<ChannelLatency>& latencies) {
+
+    if (showLatencyWindow) {
+
+        ImGui::Begin("Latency", &showLatencyWindow,
+                ImGuiWindowFlags_AlwaysAutoResize);
+
+        ImGui::Text("Latencies in ms, bins from %.2f ms to %.0f ms (log scale)",
+                LatencyHistogram::MIN_LATENCY,
+                LatencyHistogram::getBinStart(LatencyHistogram::BIN_COUNT));
+
+        for (ChannelLatency& latency : latencies) {
+
+            if (latency.published == 0) {
+                continue;
+            }
+
+            ImGui::PushID(latency.name.c_str());
+
+            ImGui::Separator();
+            ImGui::Text("%s: %llu messages, %llu never read",
+                    latency.name.c_str(),
+                    (unsigned long long)latency.published,
+                    (unsigned long long)latency.dropped);
+
+            renderLatencyHistogram(latency.readback);
+            renderLatencyHistogram(latency.publish);
+            renderLatencyHistogram(latency.acquire);
+            renderLatencyHistogram(latency.total);
+
+            ImGui::PopID();
+        }
+
+        ImGui::Separator();
+
+        char pathInputBuf[256];
+        strncpy(pathInputBuf, latencyDumpPath.c_str(), sizeof(pathInputBuf) - 1);
+        pathInputBuf[sizeof(pathInputBuf) - 1] = '\0';
+        ImGui::InputText("path", pathInputBuf, IM_ARRAYSIZE(pathInputBuf));
+        latencyDumpPath = std::string(pathInputBuf);
+
+        if (ImGui::Button("Save JSON")) {
+            if (!storage::save(latencies, latencyDumpPath)) {
+                errorMessage = "Could not write " + latencyDumpPath + "!";
+            }
+        }
+
+        ImGui::SameLine();
+
+        if (ImGui::Button("Reset")) {
+            for (ChannelLatency& latency : latencies) {
+                latency.reset();
+            }
+        }
+
+        renderErrorDialog(errorMessage);
+
+        ImGui::End();
+    }
+}
+
 void GuiModule::renderAboutWindow() {
 
     if (showAboutWindow) { 
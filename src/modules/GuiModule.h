@@ -12,6 +12,14 @@ class GuiModule {
     bool showSettingsWindow = false;
     bool showRuleWindow = false;
     bool showHelpWindow = false;
+    bool showProfilerWindow = false;
+
+    // without extension, the buttons add .csv or .json
+    std::string profilerDumpPath = "profile";
+
+    bool showLatencyWindow = false;
+    std::string latencyDumpPath = "latency.json";
+
     bool showAboutWindow = false;
 
     std::string imguiIniPath;
@@ -27,6 +35,7 @@ class GuiModule {
 
     void renderCreateMenu(Scene& scene);
     void renderPoseGui(Pose& pose);
+    void renderSensorTimingGui(Car::SensorTiming& timing);
  
 public:
 
@@ -38,6 +47,8 @@ public:
     bool renderSettingsWindow(Settings& settings);
     void renderRuleWindow(const Scene::Rules& rules);
     void renderHelpWindow();
+    void renderProfilerWindow(Profiler& profiler, bool alwaysEnabled);
+    void renderLatencyWindow(std::vector<ChannelLatency>& latencies);
     void renderAboutWindow();
 
     void begin();
@@ -125,10 +125,22 @@ void ItemsModule::update(
 void ItemsModule::render(
         GLuint shaderProgramId,
         ModelStore& modelStore, 
-        std::vector<Scene::Item>& items) {
+        RenderState& renderState) {
     
-    for (Scene::Item& i : items) {
-        glm::mat4 modelMat = i.pose.getMatrix();
-        modelStore.items[i.type].render(shaderProgramId, modelMat);
+    instances.resize(ItemType::LAST_ELEMENT);
+
+    for (std::vector<Model::Instance>& typeInstances : instances) {
+        typeInstances.clear();
+    }
+
+    for (size_t i = 0; i < renderState.itemPoses.size(); i++) {
+        glm::mat4 modelMat = renderState.itemPoses[i].getMatrix();
+        glm::mat3 normalMat = glm::mat3(glm::transpose(glm::inverse(modelMat)));
+
+        instances[renderState.itemTypes[i]].push_back({modelMat, normalMat});
+    }
+
+    for (size_t type = 0; type < instances.size(); type++) {
+        modelStore.items[type].renderInstanced(shaderProgramId, instances[type]);
     }
 }
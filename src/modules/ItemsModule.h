@@ -7,6 +7,7 @@
 #include "scene/ModelStore.h"
 
 #include "scene/Scene.h"
+#include "scene/RenderState.h"
 #include "helpers/Helpers.h"
 
 class ItemsModule {
@@ -18,6 +19,12 @@ class ItemsModule {
 
     std::map<uint64_t, DynamicItemState> itemState;
 
+    /*
+     * The instances of each item type, kept between
+     * frames to avoid allocating them every frame.
+     */
+    std::vector<std::vector<Model::Instance>> instances;
+
 public:
 
     ItemsModule();
@@ -33,10 +40,14 @@ public:
             std::vector<Scene::Item>& items,
             Pose* selection);
 
+    /*
+     * Renders the items grouped by type, with one
+     * instanced draw call per type and sub model.
+     */
     void render(
             GLuint shaderProgramId,
             ModelStore& modelStore,
-            std::vector<Scene::Item>& items);
+            RenderState& renderState);
 };
 
 #endif
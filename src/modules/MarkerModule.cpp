@@ -308,7 +308,7 @@ void MarkerModule::renderMarkers(
         Scene::Selection& selection) {
 
     GLint billboardLocation =
-        glGetUniformLocation(shaderProgramId, "billboard");
+        ShaderProgram::getUniforms(shaderProgramId).billboard;
     glUniform1i(billboardLocation, true);
 
     for (const RestrictedPose& pose : modelPoses) {
@@ -464,7 +464,7 @@ void MarkerModule::render(
         Scene::Selection& selection) {
 
     GLint lightingLocation =
-        glGetUniformLocation(shaderProgramId, "lighting");
+        ShaderProgram::getUniforms(shaderProgramId).lighting;
     glUniform1i(lightingLocation, false);
 
     glm::vec3 cameraPosition = camera.pose.position;
@@ -108,11 +108,11 @@ void VisModule::addPoseTrace(Pose& pose, double simulationTime) {
 void VisModule::renderPoseTrace(GLuint shaderProgramId, Model& pointModel, double simulationTime, bool fancy) {
 
     GLint billboardLocation = 
-        glGetUniformLocation(shaderProgramId, "billboard");
+        ShaderProgram::getUniforms(shaderProgramId).billboard;
     glUniform1i(billboardLocation, true);
 
     GLint lightingLocation = 
-        glGetUniformLocation(shaderProgramId, "lighting");
+        ShaderProgram::getUniforms(shaderProgramId).lighting;
     glUniform1i(lightingLocation, false);
 
     for (StampedPose& pose : tracedPoses) {
@@ -198,11 +198,11 @@ void VisModule::renderSensors(
         Settings& settings) {
 
     GLint lightingLocation = 
-        glGetUniformLocation(shaderProgramId, "lighting");
+        ShaderProgram::getUniforms(shaderProgramId).lighting;
     glUniform1i(lightingLocation, false);
 
     GLint billboardLocation = 
-        glGetUniformLocation(shaderProgramId, "billboard");
+        ShaderProgram::getUniforms(shaderProgramId).billboard;
     glUniform1i(billboardLocation, true);
 
     glm::vec3 binaryLightSensorWorldPos = car.modelPose.getMatrix() * 
@@ -272,11 +272,11 @@ void VisModule::renderTrackPath(
         Tracks& tracks) { 
 
     GLint lightingLocation = 
-        glGetUniformLocation(shaderProgramId, "lighting");
+        ShaderProgram::getUniforms(shaderProgramId).lighting;
     glUniform1i(lightingLocation, false);
 
     GLint billboardLocation = 
-        glGetUniformLocation(shaderProgramId, "billboard");
+        ShaderProgram::getUniforms(shaderProgramId).billboard;
     glUniform1i(billboardLocation, true);
 
     std::vector<glm::vec2> path = tracks.getPath(0.1);
@@ -302,7 +302,7 @@ void VisModule::renderVisualization(
         Settings& settings) {
 
     GLint lightingLocation = 
-        glGetUniformLocation(shaderProgramId, "lighting");
+        ShaderProgram::getUniforms(shaderProgramId).lighting;
     glUniform1i(lightingLocation, false);
 
     if (settings.showVehicleTrajectory) {
@@ -327,7 +327,7 @@ void VisModule::renderVisualization(
             }
 
             GLint billboardLocation = 
-                glGetUniformLocation(shaderProgramId, "billboard");
+                ShaderProgram::getUniforms(shaderProgramId).billboard;
             glUniform1i(billboardLocation, true);
 
             glm::vec2 pos = visualization.trajectoryPoints[127];
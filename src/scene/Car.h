@@ -102,6 +102,17 @@ struct Car {
 
     } vesc;
 
+    /*
+     * Describes when a sensor takes its measurements. A sensor
+     * measures rate times per second of simulation time, shifted
+     * by phase seconds. A rate of zero disables the sensor.
+     */
+    struct SensorTiming {
+
+        float rate;
+        float phase = 0.0f;
+    };
+
     /*
      * This contains important parameters of the main
      * color camera of the vehicle.
@@ -129,6 +140,8 @@ struct Car {
         // FOV height, adjusted by varying the parameter until the image looked like an undistorted camera image
         float fovy = 1.7;
 
+        SensorTiming timing{30.0f};
+
         struct DistortionCoefficients {
 
             float radial[3] = {0, 0, 0};
@@ -163,6 +176,8 @@ struct Car {
         float colorFovy = (float) M_PI * 0.5f;
         float depthFovy = (float) M_PI * 0.25f;
 
+        SensorTiming timing{30.0f};
+
         float getColorAspectRatio() {
             return (float) colorImageWidth / (float) colorImageHeight;
         }
@@ -196,6 +211,8 @@ struct Car {
          */
         float triggerDistance = 0.3f;
 
+        SensorTiming timing{200.0f};
+
     } binaryLightSensor;
 
     struct LaserSensor {
@@ -210,6 +227,8 @@ struct Car {
          */
         float value = 1000.0f;
 
+        SensorTiming timing{200.0f};
+
     } laserSensor;
 };
 
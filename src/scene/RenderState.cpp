@@ -0,0 +1,44 @@
+#include "RenderState.h"
+
+void RenderState::capture(Scene& scene) {
+
+    time = scene.simulationClock.time;
+    tick = scene.simulationClock.ticks;
+    carModelPose = scene.car.modelPose;
+    light = scene.light;
+    groundSize = scene.groundSize;
+
+    itemIds.resize(scene.items.size());
+    itemTypes.resize(scene.items.size());
+    itemPoses.resize(scene.items.size());
+
+    for (size_t i = 0; i < scene.items.size(); i++) {
+        itemIds[i] = scene.items[i].id;
+        itemTypes[i] = scene.items[i].type;
+        itemPoses[i] = scene.items[i].pose;
+    }
+}
+
+void RenderState::interpolate(
+        const RenderState& previous,
+        const RenderState& current,
+        float factor) {
+
+    time = previous.time + (current.time - previous.time) * factor;
+    tick = current.tick;
+    carModelPose = Pose(previous.carModelPose).mix(current.carModelPose, factor);
+    light = current.light;
+    groundSize = current.groundSize;
+
+    itemIds = current.itemIds;
+    itemTypes = current.itemTypes;
+    itemPoses = current.itemPoses;
+
+    if (previous.itemIds != current.itemIds) {
+        return;
+    }
+
+    for (size_t i = 0; i < itemPoses.size(); i++) {
+        itemPoses[i] = Pose(previous.itemPoses[i]).mix(itemPoses[i], factor);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef INC_2019_RENDERSTATE_H
+#define INC_2019_RENDERSTATE_H
+
+#include <memory>
+#include <vector>
+
+#include "helpers/Helpers.h"
+#include "scene/Scene.h"
+
+/*
+ * The render state contains everything the renderer needs from the
+ * scene, i.e. the poses of the car and the types and poses of the
+ * items, the light and the ground size. The poses of the car cameras
+ * are derived from the car pose. The track models are not captured
+ * with the scene, but collected by the editor on the render thread,
+ * which owns them (see Editor::captureTrackModels).
+ *
+ * The simulation is updated with a fixed time step, which is
+ * usually not a multiple of the display frame time. To get a
+ * smooth result anyway, the render state is captured after every
+ * simulation tick and the last two states are interpolated by the
+ * time left in the simulation clock accumulator before rendering.
+ * This is way cheaper than copying and updating the whole Scene.
+ */
+struct RenderState {
+
+    /*
+     * The simulation time at which this state was captured.
+     * Negative if nothing was captured yet.
+     */
+    double time = -1;
+
+    /*
+     * The simulation tick at which this state was captured.
+     */
+    uint64_t tick = 0;
+
+    Pose carModelPose;
+
+    /*
+     * The ids, types and poses of the scene items, in the
+     * same order as the items in the scene.
+     */
+    std::vector<uint64_t> itemIds;
+    std::vector<ItemType> itemTypes;
+    std::vector<Pose> itemPoses;
+
+    PointLight light;
+
+    float groundSize = 0.0f;
+
+    /*
+     * An uploaded track model and the matrix it is rendered with.
+     */
+    struct TrackModel {
+        std::shared_ptr<Model> model;
+        glm::mat4 modelMat;
+    };
+
+    std::vector<TrackModel> trackModels;
+
+    /*
+     * Copies the poses, the light and the ground size from the scene.
+     * The memory of the item vectors is reused between calls.
+     */
+    void capture(Scene& scene);
+
+    /*
+     * Sets this state to the interpolation between the previous and
+     * the current state. If the items differ between the two states
+     * (e.g. an item was added) the current item poses are used.
+     * The track models are left untouched.
+     */
+    void interpolate(
+            const RenderState& previous,
+            const RenderState& current,
+            float factor);
+};
+
+#endif
@@ -16,7 +16,7 @@ Scene::Scene(std::string path) : version{VERSION} {
 Scene::~Scene() {
 }
 
-std::deque<Scene> Scene::history;
+thread_local std::deque<Scene> Scene::history;
 
 void Scene::addToHistory() {
     
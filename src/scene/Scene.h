@@ -303,8 +303,10 @@ struct Scene {
 
     /*
      * Contains the last 10 simulated seconds of Scene objects.
+     * There is one history per thread, so that scenes simulated
+     * on other threads (see BatchSimulator) do not interfere.
      */
-    static std::deque<Scene> history;
+    static thread_local std::deque<Scene> history;
 
     /*
      * Adds this scene to the scene history.
@@ -41,11 +41,80 @@ struct Settings {
      */
     bool fullscreen = false;
 
+    /*
+     * If set, no window is opened and only the sensor images of the
+     * car are rendered into an offscreen (EGL) context. This is meant
+     * for running the simulator on machines without a display.
+     */
+    bool headless = false;
+
     /*
      * The speed of the simulation given as fraction of real time.
      */
     float simulationSpeed = 0.25f;
 
+    /*
+     * If set, the simulation runs as fast as possible instead of
+     * following the wall clock (simulationSpeed is ignored). Camera
+     * images are then rendered in between the ticks, when due.
+     */
+    bool fastForward = false;
+
+    /*
+     * If set, every simulation tick waits until the external controller
+     * acknowledged the previous car state with a vesc command. This
+     * implies fastForward, as the controller paces the simulation.
+     */
+    bool lockstep = false;
+
+    /*
+     * The wall clock time (in seconds) to wait for the acknowledgement
+     * of the controller in lockstep mode.
+     */
+    float lockstepTimeout = 1.0f;
+
+    /*
+     * If set, the simulation ticks run on a separate thread, so that
+     * they are not delayed by the rendering. Not available in fast
+     * forward mode, as the camera images are rendered between ticks.
+     */
+    bool threadedSimulation = false;
+
+    /*
+     * Selects the shared memory keys used to communicate with the
+     * controller. Simulators running on the same machine at the
+     * same time need different instances.
+     */
+    int sharedMemoryInstance = 0;
+
+    /*
+     * If set, named POSIX shared memory is used instead of SysV
+     * segments. Optionally backed by huge pages, which reduces TLB
+     * misses when large camera images are read.
+     */
+    bool posixSharedMemory = false;
+    bool hugePages = false;
+
+    /*
+     * The number of camera images that can be in flight between the
+     * gpu and the shared memory (see Capture). Deeper rings drop fewer
+     * images when the gpu falls behind, at the cost of latency.
+     */
+    int captureDepth = 3;
+
+    /*
+     * If not empty, the profiler is always enabled (also in headless
+     * mode) and its history is written to this file when the loop
+     * returns, as JSON if the path ends in .json, as CSV otherwise.
+     */
+    std::string profilePath;
+
+    /*
+     * If not empty, all messages sent and received over the shared
+     * memory are recorded to this file, see ChannelRecorder.
+     */
+    std::string recordPath;
+
     /*
      * The delta time (in seconds) for one simulation update. 
      */
@@ -1,6 +1,7 @@
 #include "Tracks.h"
 
 #include <algorithm>
+#include <map>
 
 ControlPoint::ControlPoint() {
 }
@@ -159,6 +160,54 @@ std::vector<glm::vec2> TrackIntersection::getPoints(float /*pointDistance*/) {
     return pathPoints;
 }
 
+Tracks Tracks::clone() const {
+
+    Tracks copy = *this;
+
+    copy.tracks.clear();
+    copy.trackSelection = TrackSelection();
+
+    std::map<const ControlPoint*, std::shared_ptr<ControlPoint>> controlPoints;
+
+    for (const std::shared_ptr<ControlPoint>& cp : tracks) {
+        controlPoints[cp.get()] = std::make_shared<ControlPoint>(cp->coords);
+        copy.tracks.push_back(controlPoints[cp.get()]);
+    }
+
+    auto getCopy = [&](const std::weak_ptr<ControlPoint>& cp) {
+        return controlPoints.at(cp.lock().get());
+    };
+
+    for (const std::shared_ptr<TrackBase>& track : getTrackSegments()) {
+
+        if (TrackLine* line = dynamic_cast<TrackLine*>(track.get())) {
+            std::shared_ptr<TrackLine> lineCopy =
+                copy.addTrackLine(getCopy(line->start), getCopy(line->end));
+            lineCopy->centerLine = line->centerLine;
+            lineCopy->rightLineMissing = line->rightLineMissing;
+            lineCopy->leftLineMissing = line->leftLineMissing;
+        } else if (TrackArc* arc = dynamic_cast<TrackArc*>(track.get())) {
+            std::shared_ptr<TrackArc> arcCopy = copy.addTrackArc(
+                    getCopy(arc->start),
+                    getCopy(arc->end),
+                    arc->center,
+                    arc->radius,
+                    arc->rightArc);
+            arcCopy->centerLine = arc->centerLine;
+            arcCopy->rightLineMissing = arc->rightLineMissing;
+            arcCopy->leftLineMissing = arc->leftLineMissing;
+        } else if (TrackIntersection* intersection = dynamic_cast<TrackIntersection*>(track.get())) {
+            std::vector<std::shared_ptr<ControlPoint>> links;
+            for (const std::weak_ptr<ControlPoint>& link : intersection->links) {
+                links.push_back(getCopy(link));
+            }
+            copy.addTrackIntersection(getCopy(intersection->center), links);
+        }
+    }
+
+    return copy;
+}
+
 const std::vector<std::shared_ptr<ControlPoint>>& Tracks::getTracks() const {
 
     return tracks;
@@ -124,6 +124,13 @@ public:
 
     } trackSelection;
 
+    /*
+     * Copying Tracks shares the control points and the tracks,
+     * this returns a copy with its own control points and tracks.
+     * The track selection is not copied.
+     */
+    Tracks clone() const;
+
     const std::vector<std::shared_ptr<ControlPoint>>& getTracks() const;
     const std::vector<std::shared_ptr<TrackBase>> getTrackSegments() const;
 
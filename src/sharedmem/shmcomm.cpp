@@ -1,10 +1,22 @@
 #include "shmcomm.h"
 #include <iostream>
+#include <algorithm>
 #include <errno.h>
 #include <string.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <fcntl.h>
+#include <string>
+#include <signal.h>
 #include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <chrono>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 using namespace SimulatorSHM;
 using namespace std;
@@ -21,75 +33,526 @@ Image* a = shm::recv(imageStream);
 
 */
 
-SHMCommPrivate::SHMCommPrivate(int key, size_t bufsize)
+/*
+ * Changes whenever the layout of the segment changes, so that
+ * segments of an older version are initialized again.
+ */
+const uint64_t SEGMENT_MAGIC = 0x5350415453484d05;
+
+/*
+ * Buffers start on their own cache line, so that processes working
+ * on different buffers do not slow down each other (false sharing).
+ */
+const size_t ALIGNMENT = 64;
+
+static uint64_t makeLock(uint64_t state, pid_t pid) {
+
+    return ((uint64_t)(uint32_t)pid << 32) | state;
+}
+
+static uint64_t getState(uint64_t lock) {
+
+    return lock & 0xffffffff;
+}
+
+static pid_t getPid(uint64_t lock) {
+
+    return (pid_t)(lock >> 32);
+}
+
+/*
+ * CLOCK_MONOTONIC is the same for all processes on the machine,
+ * so the times stamped by different processes can be compared.
+ */
+static uint64_t getMonotonicNanoseconds() {
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+/*
+ * The segment is shared between processes, therefore
+ * the non-private futex operations have to be used.
+ */
+static void futexWait(atomic<uint32_t>& word, uint32_t expected, const timespec * timeout) {
+
+    syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+static void futexWakeAll(atomic<uint32_t>& word) {
+
+    syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+SHMCommPrivate::SHMCommPrivate(int key, size_t bufsize, int bufferCount)
 {
     this->key = key;
     this->buffersize = bufsize;
+    this->bufferCount = max(1, min(bufferCount, NBUFFERS));
+    this->describedBySegment = bufsize == 0;
+    this->mappedSize = 0;
+    this->backend = BACKEND_SYSV;
+    this->hugePages = false;
     this->shmId = -1;
     this->shmPtr = nullptr;
-    this->gWriteId = 0;
+    this->header = nullptr;
     this->shmsize = 0;
+    this->lastReadId = 0;
+    this->lockedPublishTime = 0;
+    this->lockedAcquireTime = 0;
 }
 
 size_t align(size_t sz) {
 
-    if (sz % 8 != 0) {
-        sz += 8 - sz % 8;
+    if (sz % ALIGNMENT != 0) {
+        sz += ALIGNMENT - sz % ALIGNMENT;
     }
 
     return sz;
 }
 
+void SHMCommPrivate::setBackend(Backend backend, bool hugePages)
+{
+    this->backend = backend;
+    this->hugePages = hugePages;
+}
+
+static string getPosixName(int key)
+{
+    return "/spatzsim-" + to_string(key);
+}
+
+static string getHugetlbPath(int key)
+{
+    return "/dev/hugepages/spatzsim-" + to_string(key);
+}
+
+bool SHMCommPrivate::openPosix(int flags, bool& hugetlb)
+{
+    hugetlb = false;
+
+    if (hugePages) {
+        shmId = open(getHugetlbPath(key).c_str(), flags, 0666);
+
+        if (shmId >= 0 || errno == EEXIST) {
+            hugetlb = shmId >= 0;
+            return shmId >= 0;
+        }
+    }
+
+    shmId = shm_open(getPosixName(key).c_str(), flags, 0666);
+
+    return shmId >= 0;
+}
+
+bool SHMCommPrivate::mapSegment(size_t size, bool& created, bool& sizeMismatch)
+{
+    created = false;
+    sizeMismatch = false;
+
+    if (BACKEND_SYSV == backend) {
+
+        created = true;
+
+        shmId = shmget(key, size, IPC_CREAT | IPC_EXCL | 0666);
+
+        if (shmId < 0 && errno == EEXIST) {
+            created = false;
+            shmId = shmget(key, size, IPC_CREAT | 0666);
+        }
+
+        if (shmId < 0) {
+            sizeMismatch = errno == EINVAL;
+            if (!sizeMismatch) {
+                cerr << "shmget failed miserably: " << strerror(errno) << endl;
+            }
+            return false;
+        }
+
+        // shmget only fails for segments smaller than requested,
+        // larger ones have to be found by their actual size
+
+        struct shmid_ds ds;
+
+        if (!created && (shmctl(shmId, IPC_STAT, &ds) < 0 || ds.shm_segsz != size)) {
+            sizeMismatch = true;
+            return false;
+        }
+
+        shmPtr = shmat(shmId, nullptr, 0);
+
+        if (shmPtr == (void*)-1) {
+            shmPtr = nullptr;
+            cerr << "shmat failed miserably: " << strerror(errno) << endl;
+            return false;
+        }
+
+        mappedSize = size;
+
+        return true;
+    }
+
+    bool hugetlb = false;
+
+    created = openPosix(O_RDWR | O_CREAT | O_EXCL, hugetlb);
+
+    if (!created && (errno != EEXIST || !openPosix(O_RDWR, hugetlb))) {
+        cerr << "shm_open failed miserably: " << strerror(errno) << endl;
+        return false;
+    }
+
+    // hugetlbfs files can only be mapped in multiples of the huge page size
+
+    mappedSize = size;
+
+    struct statfs fs;
+
+    if (hugetlb && fstatfs(shmId, &fs) == 0 && fs.f_bsize > 0) {
+        mappedSize = align(size) + (size_t)fs.f_bsize - 1;
+        mappedSize -= mappedSize % (size_t)fs.f_bsize;
+    }
+
+    if (created) {
+        if (ftruncate(shmId, mappedSize) < 0) {
+            cerr << "ftruncate failed miserably: " << strerror(errno) << endl;
+            close(shmId);
+            removeSegment();
+            return false;
+        }
+    } else {
+        struct stat st;
+
+        // the creator sizes the segment right after creating it, until
+        // then it is empty and must not be taken for another layout
+
+        int result = fstat(shmId, &st);
+
+        for (int i = 0; result == 0 && st.st_size == 0 && i < 1000; i++) {
+            usleep(1000);
+            result = fstat(shmId, &st);
+        }
+
+        if (result < 0) {
+            cerr << "fstat failed miserably: " << strerror(errno) << endl;
+            close(shmId);
+            return false;
+        }
+
+        // still empty, the creator probably crashed
+
+        if ((size_t)st.st_size != mappedSize) {
+            sizeMismatch = true;
+            close(shmId);
+            return false;
+        }
+    }
+
+    shmPtr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, shmId, 0);
+
+    // the mapping stays valid after closing the file
+    close(shmId);
+
+    if (shmPtr == MAP_FAILED) {
+        shmPtr = nullptr;
+        cerr << "mmap failed miserably: " << strerror(errno) << endl;
+        return false;
+    }
+
+    if (hugePages && !hugetlb) {
+        madvise(shmPtr, mappedSize, MADV_HUGEPAGE);
+    }
+
+    return true;
+}
+
+bool SHMCommPrivate::mapExistingSegment()
+{
+    if (BACKEND_SYSV == backend) {
+
+        shmId = shmget(key, 0, 0666);
+
+        if (shmId < 0) {
+            return false;
+        }
+
+        struct shmid_ds ds;
+
+        if (shmctl(shmId, IPC_STAT, &ds) < 0) {
+            return false;
+        }
+
+        shmPtr = shmat(shmId, nullptr, 0);
+
+        if (shmPtr == (void*)-1) {
+            shmPtr = nullptr;
+            return false;
+        }
+
+        mappedSize = ds.shm_segsz;
+
+        return true;
+    }
+
+    bool hugetlb = false;
+
+    if (!openPosix(O_RDWR, hugetlb)) {
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(shmId, &st) < 0 || st.st_size == 0) {
+        close(shmId);
+        return false;
+    }
+
+    mappedSize = st.st_size;
+    shmPtr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, shmId, 0);
+
+    close(shmId);
+
+    if (shmPtr == MAP_FAILED) {
+        shmPtr = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void SHMCommPrivate::removeSegment()
+{
+    // the segment is only destroyed after the last process detached
+
+    if (BACKEND_SYSV == backend) {
+        int oldId = shmget(key, 0, 0666);
+
+        if (oldId >= 0) {
+            shmctl(oldId, IPC_RMID, nullptr);
+        }
+    } else {
+        if (hugePages) {
+            unlink(getHugetlbPath(key).c_str());
+        }
+        shm_unlink(getPosixName(key).c_str());
+    }
+}
+
+void SHMCommPrivate::invalidateSegment()
+{
+    // tells everybody attached to the segment to attach again
+
+    if (shmPtr == nullptr && mapExistingSegment()) {
+        header = (SegmentHeader*)shmPtr;
+    }
+
+    if (header != nullptr
+            && mappedSize >= sizeof(SegmentHeader)
+            && header->magic.load(memory_order_acquire) == SEGMENT_MAGIC) {
+        header->invalidated.store(1, memory_order_release);
+        header->notify.fetch_add(1);
+        futexWakeAll(header->notify);
+    }
+
+    detach();
+}
+
 bool SHMCommPrivate::_attach()
 {
-    shmsize = align(sizeof(Buffer)) + align(buffersize);
-    shmsize *= NBUFFERS;
+    if (describedBySegment) {
+        return attachExisting();
+    }
+
+    shmsize = align(sizeof(SegmentHeader))
+        + (align(sizeof(Buffer)) + align(buffersize)) * bufferCount;
 
     /*
      * If we want a shared memory segment and it is not
      * there, we create it. We don't care if we are the
      * server or the client or whatever ...
+     * But only the process that created the segment initializes
+     * it, the buffers might already be in use by the others.
      */
-    shmId = shmget(key, shmsize, IPC_CREAT | 0666);
+    bool created = false;
+    bool sizeMismatch = false;
+
+    bool mapped = mapSegment(shmsize, created, sizeMismatch);
+    bool initialized = false;
+
+    if (mapped) {
+        header = (SegmentHeader*)shmPtr;
+        initialized = !created && waitForInitialization();
+
+        // a segment of the same size may still be split up
+        // differently, the buffers would not line up then
 
-    if (shmId < 0) {
-        if (errno == EINVAL) {
-            int shmId = shmget(key, 0, 0666);
-            shmctl(shmId, IPC_RMID, nullptr);
-            cerr << "The call to shmget(...) failed because the shared memory segment changed size." << endl;
-            cerr << "Restart simulator to reallocate shared memory." << endl;
+        if (initialized
+                && (header->bufferSize != buffersize
+                    || header->bufferCount != (uint32_t)bufferCount)) {
+            detach();
+            mapped = false;
+            sizeMismatch = true;
         }
-        cerr << "shmget failed miserably: " << strerror(errno) << endl;
+    }
+
+    if (!mapped) {
+
+        if (!sizeMismatch) {
+            return false;
+        }
+
+        // a segment of an older layout, it is replaced and
+        // the processes still using it are told to attach again
+
+        cerr << "Shared memory segment " << key << " changed its layout, replacing it." << endl;
+
+        invalidateSegment();
+        removeSegment();
+
+        if (!mapSegment(shmsize, created, sizeMismatch)) {
+            return false;
+        }
+
+        header = (SegmentHeader*)shmPtr;
+        initialized = !created && waitForInitialization();
+    }
+
+    if (!initialized) {
+        if (!created) {
+            cerr << "Shared memory segment " << key << " was not initialized, initializing it now." << endl;
+        }
+        initialize();
+    }
+
+    mapBuffers();
+    
+    return true;
+}
+
+bool SHMCommPrivate::attachExisting()
+{
+    if (!mapExistingSegment()) {
+        cerr << "Shared memory segment " << key << " does not exist: " << strerror(errno) << endl;
+        return false;
+    }
+
+    header = (SegmentHeader*)shmPtr;
+
+    if (mappedSize < sizeof(SegmentHeader) || !waitForInitialization()) {
+        cerr << "Shared memory segment " << key << " was not initialized." << endl;
+        detach();
         return false;
     }
 
-    shmPtr = shmat(shmId, nullptr, 0);
+    buffersize = header->bufferSize;
+    bufferCount = max(1, min((int)header->bufferCount, NBUFFERS));
+    shmsize = align(sizeof(SegmentHeader))
+        + (align(sizeof(Buffer)) + align(buffersize)) * bufferCount;
 
-    if (shmPtr == (void*)-1) {
-        cerr << "shmat failed miserably: " << strerror(errno) << endl;
+    if (shmsize > mappedSize) {
+        cerr << "Shared memory segment " << key << " is too small for its layout." << endl;
+        detach();
         return false;
     }
 
+    mapBuffers();
+
+    return true;
+}
+
+bool SHMCommPrivate::_create(size_t bufsize, int bufferCount)
+{
+    invalidateSegment();
+    removeSegment();
+
+    this->buffersize = bufsize;
+    this->bufferCount = max(1, min(bufferCount, NBUFFERS));
+    this->describedBySegment = false;
+
+    return _attach();
+}
+
+bool SHMCommPrivate::_invalidated()
+{
+    return header != nullptr && header->invalidated.load(memory_order_acquire) != 0;
+}
+
+int SHMCommPrivate::_key()
+{
+    return key;
+}
+
+size_t SHMCommPrivate::_bufferSize()
+{
+    return buffersize;
+}
+
+int SHMCommPrivate::_bufferCount()
+{
+    return bufferCount;
+}
+
+void SHMCommPrivate::mapBuffers()
+{
     char * cptr = (char*)shmPtr;
-    size_t offset = 0;
+    size_t offset = align(sizeof(SegmentHeader));
 
-    for (int i = 0; i < NBUFFERS; i++) {
+    for (int i = 0; i < bufferCount; i++) {
         buffers[i] = (Buffer*)(cptr+offset);
         offset += align(sizeof(Buffer));
+        offset += align(buffersize);
+    }
+}
+
+void SHMCommPrivate::initialize()
+{
+    mapBuffers();
+
+    for (int i = 0; i < bufferCount; i++) {
+        buffers[i]->lock.store(makeLock(FREE, 0), memory_order_relaxed);
+        buffers[i]->writeId.store(0, memory_order_relaxed);
         buffers[i]->bufferSize = buffersize;
-        buffers[i]->state = FREE;
-        buffers[i]->writeId = 0;
-        offset += align(sizeof(buffersize));
+        buffers[i]->publishTime.store(0, memory_order_relaxed);
+        buffers[i]->acquireTime.store(0, memory_order_relaxed);
     }
-    
-    return true;
+
+    header->writeId.store(0, memory_order_relaxed);
+    header->publishedId.store(0, memory_order_relaxed);
+    header->notify.store(0, memory_order_relaxed);
+    header->waiters.store(0, memory_order_relaxed);
+    header->bufferSize = buffersize;
+    header->bufferCount = bufferCount;
+    header->invalidated.store(0, memory_order_relaxed);
+    header->magic.store(SEGMENT_MAGIC, memory_order_release);
+}
+
+bool SHMCommPrivate::waitForInitialization()
+{
+    // the creator of the segment initializes it right after creating,
+    // if that does not happen it probably crashed or the segment is
+    // left over from an older version
+
+    for (int i = 0; i < 1000; i++) {
+        if (header->magic.load(memory_order_acquire) == SEGMENT_MAGIC) {
+            return true;
+        }
+        usleep(1000);
+    }
+
+    return false;
 }
 
 void SHMCommPrivate::detach()
 {
     if (shmPtr != nullptr) {
-        shmdt(shmPtr);
+        if (BACKEND_SYSV == backend) {
+            shmdt(shmPtr);
+        } else {
+            munmap(shmPtr, mappedSize);
+        }
         shmPtr = nullptr;
+        header = nullptr;
     }
 }
 
@@ -98,10 +561,68 @@ bool SHMCommPrivate::destroy()
     // if(shmId < 0) shmId = shmget(key, shmsize, 0666);
     // if(shmId < 0) return false;
     // shmctl(shmId, IPC_RMID, nullptr);
+
+    if (BACKEND_POSIX == backend) {
+        invalidateSegment();
+        removeSegment();
+    }
+
     return true;
 }
 
-void *SHMCommPrivate::_lock(LockMode mode)
+bool SHMCommPrivate::tryLock(Buffer * buffer, BufferState from, BufferState to)
+{
+    uint64_t current = buffer->lock.load(memory_order_acquire);
+
+    if (getState(current) != (uint64_t)from) {
+        return false;
+    }
+
+    return buffer->lock.compare_exchange_strong(
+            current,
+            makeLock(to, getpid()),
+            memory_order_acq_rel,
+            memory_order_acquire);
+}
+
+bool SHMCommPrivate::reclaimStaleBuffers()
+{
+    // buffers locked by a process that does not exist anymore
+    // would be blocked forever, so they are freed again
+
+    bool reclaimed = false;
+
+    for (int i = 0; i < bufferCount; i++) {
+
+        uint64_t current = buffers[i]->lock.load(memory_order_acquire);
+        uint64_t state = getState(current);
+        pid_t pid = getPid(current);
+
+        if ((state != READING && state != WRITING) || pid == 0 || pid == getpid()) {
+            continue;
+        }
+
+        if (kill(pid, 0) < 0 && errno == ESRCH) {
+            reclaimed |= buffers[i]->lock.compare_exchange_strong(
+                    current,
+                    makeLock(FREE, 0),
+                    memory_order_acq_rel);
+        }
+    }
+
+    return reclaimed;
+}
+
+void SHMCommPrivate::takeOverwrittenStamps(Buffer * buffer)
+{
+    // the stamps are made visible by the state transitions, as the
+    // buffer is written and read before it is locked for writing
+
+    lockedPublishTime = buffer->publishTime.load(memory_order_relaxed);
+    lockedAcquireTime = buffer->acquireTime.exchange(0, memory_order_relaxed);
+}
+
+void *SHMCommPrivate::lockOnce(LockMode mode)
 {
     uint64_t bestId = 0;
 
@@ -111,33 +632,43 @@ void *SHMCommPrivate::_lock(LockMode mode)
 
     Buffer * bestBuf = nullptr;
 
-    for(int i = 0; i < NBUFFERS; i++){
+    for(int i = 0; i < bufferCount; i++){
+
+        uint64_t state = getState(buffers[i]->lock.load(memory_order_acquire));
+        uint64_t writeId = buffers[i]->writeId.load(memory_order_relaxed);
+
         if(mode == WRITE_NO_OVERWRITE || mode == WRITE_OVERWRITE_OLDEST){
-            if(buffers[i]->state == FREE){
-                gWriteId++;
-                buffers[i]->state = WRITING;
-                buffers[i]->writeId = gWriteId;
+            if(state == FREE){
+                if (!tryLock(buffers[i], FREE, WRITING)) {
+                    continue;
+                }
+
+                buffers[i]->writeId.store(
+                        header->writeId.fetch_add(1, memory_order_relaxed) + 1,
+                        memory_order_relaxed);
+
+                takeOverwrittenStamps(buffers[i]);
 
                 char * ptr = (char*)buffers[i];
                 ptr+=align(sizeof(Buffer));
 
                 return ptr;
-            }else if(buffers[i]->state == DATA && mode == WRITE_OVERWRITE_OLDEST){
-                if(buffers[i]->writeId < bestId){
+            }else if(state == DATA && mode == WRITE_OVERWRITE_OLDEST){
+                if(writeId < bestId){
                     bestBuf = buffers[i];
-                    bestId = buffers[i]->writeId;
+                    bestId = writeId;
                 }
             }
-        } else if (buffers[i]->state == DATA) {
+        } else if (state == DATA) {
             if(mode == READ_OLDEST){
-                if(buffers[i]->writeId < bestId){
+                if(writeId < bestId){
                     bestBuf = buffers[i];
-                    bestId = buffers[i]->writeId;
+                    bestId = writeId;
                 }
             }else{
-                if(buffers[i]->writeId > bestId){
+                if(writeId > bestId){
                     bestBuf = buffers[i];
-                    bestId = buffers[i]->writeId;
+                    bestId = writeId;
                 }
             }
         }
@@ -148,11 +679,27 @@ void *SHMCommPrivate::_lock(LockMode mode)
     } else if (bestBuf == nullptr) {
         return nullptr;
     } else if (mode == WRITE_OVERWRITE_OLDEST) {
-        gWriteId++;
-        bestBuf->state = WRITING;
-        bestBuf->writeId = gWriteId;
+        if (!tryLock(bestBuf, DATA, WRITING)) {
+            return nullptr;
+        }
+        bestBuf->writeId.store(
+                header->writeId.fetch_add(1, memory_order_relaxed) + 1,
+                memory_order_relaxed);
+
+        takeOverwrittenStamps(bestBuf);
     } else {
-        bestBuf->state = READING;
+        if (!tryLock(bestBuf, DATA, READING)) {
+            return nullptr;
+        }
+        if (bestId > lastReadId) {
+            lastReadId = bestId;
+        }
+
+        // the writer sees the acquire time once the buffer is free again
+
+        lockedPublishTime = bestBuf->publishTime.load(memory_order_relaxed);
+        lockedAcquireTime = getMonotonicNanoseconds();
+        bestBuf->acquireTime.store(lockedAcquireTime, memory_order_relaxed);
     }
 
     char * ptr = (char*)bestBuf;
@@ -161,16 +708,118 @@ void *SHMCommPrivate::_lock(LockMode mode)
     return ptr;
 }
 
+void *SHMCommPrivate::_lock(LockMode mode)
+{
+    // Every state transition is a compare and swap on the buffer
+    // lock. If another process changed a buffer between looking at
+    // it and locking it, the buffers are simply scanned again.
+
+    for (int attempt = 0; attempt < 2 * bufferCount; attempt++) {
+
+        void * ptr = lockOnce(mode);
+
+        if (ptr != nullptr) {
+            return ptr;
+        }
+
+        bool writing = mode == WRITE_NO_OVERWRITE || mode == WRITE_OVERWRITE_OLDEST;
+
+        if (writing && !reclaimStaleBuffers() && attempt > 0) {
+            break;
+        }
+    }
+
+    return nullptr;
+}
+
 void SHMCommPrivate::_unlock(void *buffer)
 {
     char* ptr = (char*)buffer;
     ptr = ptr-align(sizeof (Buffer));
     Buffer * bp = (Buffer*)ptr;
 
-    if (bp->state == READING) bp->state = FREE;
-    else bp->state = DATA;
+    // the release store makes the written data visible
+    // to the reader that locks this buffer afterwards
+
+    if (getState(bp->lock.load(memory_order_relaxed)) == READING) {
+        bp->lock.store(makeLock(FREE, 0), memory_order_release);
+        return;
+    }
+
+    bp->publishTime.store(getMonotonicNanoseconds(), memory_order_relaxed);
+    bp->lock.store(makeLock(DATA, 0), memory_order_release);
+
+    uint64_t writeId = bp->writeId.load(memory_order_relaxed);
+    uint64_t publishedId = header->publishedId.load(memory_order_relaxed);
+
+    while (publishedId < writeId
+            && !header->publishedId.compare_exchange_weak(publishedId, writeId)) {
+    }
+
+    // the futex syscall is only needed if somebody is actually waiting
+
+    header->notify.fetch_add(1);
+
+    if (header->waiters.load() > 0) {
+        futexWakeAll(header->notify);
+    }
+}
+
+bool SHMCommPrivate::_waitNewer(float timeout)
+{
+    if (header == nullptr) {
+        return false;
+    }
+
+    auto deadline = chrono::steady_clock::now()
+        + chrono::microseconds((long)(timeout * 1000000.0f));
+
+    bool published = false;
+
+    header->waiters.fetch_add(1);
+
+    while (true) {
+
+        // the futex word has to be read before checking for new data,
+        // otherwise a publish in between would not wake us up
+
+        uint32_t notify = header->notify.load();
+
+        if (header->publishedId.load() > lastReadId) {
+            published = true;
+            break;
+        }
+
+        if (header->invalidated.load() != 0) {
+            break;
+        }
+
+        auto remaining = deadline - chrono::steady_clock::now();
+
+        if (remaining <= chrono::nanoseconds(0)) {
+            break;
+        }
+
+        long nanoseconds = chrono::duration_cast<chrono::nanoseconds>(remaining).count();
+
+        timespec ts;
+        ts.tv_sec = nanoseconds / 1000000000;
+        ts.tv_nsec = nanoseconds % 1000000000;
+
+        futexWait(header->notify, notify, &ts);
+    }
+
+    header->waiters.fetch_sub(1);
+
+    return published;
+}
+
+bool SHMCommPrivate::_lockedStamps(double& publishTime, double& acquireTime)
+{
+    publishTime = lockedPublishTime * 1e-9;
+    acquireTime = lockedAcquireTime * 1e-9;
 
-    return;
+    return lockedPublishTime != 0;
 }
 
 SHMCommPrivate::~SHMCommPrivate() {
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <inttypes.h>
+#include <atomic>
 
 #define NBUFFERS 4
 
@@ -16,33 +17,154 @@ enum LockMode{
     WRITE_NO_OVERWRITE, WRITE_OVERWRITE_OLDEST, READ_OLDEST, READ_NEWEST
 };
 
+/*
+ * SYSV uses shmget segments, which are never removed, so they survive
+ * restarts of the simulator. POSIX uses named shared memory objects
+ * (/dev/shm/spatzsim-<key>), which are removed by destroy. With huge
+ * pages, POSIX segments are created on hugetlbfs (/dev/hugepages) if
+ * it is mounted and writable, otherwise transparent huge pages are
+ * requested for the mapping. All processes using a segment have to
+ * use the same backend.
+ */
+enum Backend{
+    BACKEND_SYSV, BACKEND_POSIX
+};
+
+/*
+ * The segment starts with this header, followed by NBUFFERS times
+ * a Buffer header and its data. All fields that are changed after
+ * the initialization are atomics, as they are accessed by several
+ * processes at once. The atomics used here are lock-free and thus
+ * address-free, so they also work across processes.
+ */
+struct SegmentHeader{
+    // set to SEGMENT_MAGIC once the segment is initialized
+    std::atomic<uint64_t> magic;
+    // the layout of the segment, so that it can be attached
+    // without knowing the size of the buffers in advance
+    uint64_t bufferSize;
+    uint32_t bufferCount;
+    // set when the segment is replaced by one with a different
+    // layout, attached processes have to attach again
+    std::atomic<uint32_t> invalidated;
+    // the id of the last buffer locked for writing
+    std::atomic<uint64_t> writeId;
+    // the highest write id of all buffers published so far
+    std::atomic<uint64_t> publishedId;
+    // futex word, incremented whenever a buffer is published
+    std::atomic<uint32_t> notify;
+    // the number of processes waiting on the futex word
+    std::atomic<uint32_t> waiters;
+};
+
+/*
+ * The state of a buffer and the pid of the process holding it
+ * are combined in one word (pid << 32 | state), so both can be
+ * changed with a single compare and swap.
+ */
 struct Buffer{
-    size_t bufferSize;
-    BufferState state;
-    uint64_t writeId;
+    std::atomic<uint64_t> lock;
+    std::atomic<uint64_t> writeId;
+    uint64_t bufferSize;
+    // nanoseconds of CLOCK_MONOTONIC when the data was published
+    // and when it was locked by a reader (0 if it was not read yet)
+    std::atomic<uint64_t> publishTime;
+    std::atomic<uint64_t> acquireTime;
 };
 
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "shared memory requires lock-free 64 bit atomics");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+        "the futex word must be a plain 32 bit integer");
+
 class SHMCommPrivate
 {
 public:
-    SHMCommPrivate(int key,size_t bufsize);
+    /*
+     * A buffer size of 0 attaches to an existing segment
+     * and takes the buffer size and count from its header.
+     */
+    SHMCommPrivate(int key, size_t bufsize, int bufferCount = NBUFFERS);
+
+    /*
+     * Must be called before attaching.
+     */
+    void setBackend(Backend backend, bool hugePages);
 
     void detach();
+
+    /*
+     * Removes a POSIX segment, processes still attached to it are
+     * told to attach again. SysV segments are kept on purpose.
+     */
     bool destroy();
     bool _attach();
+
+    /*
+     * Replaces the segment with a new one of the given layout.
+     * An existing segment is invalidated and removed, processes
+     * still attached to it keep it until they detach.
+     */
+    bool _create(size_t bufsize, int bufferCount);
+
+    bool _invalidated();
+    int _key();
+    size_t _bufferSize();
+    int _bufferCount();
+
     void *_lock(LockMode mode);
     void _unlock(void * buffer);
 
+    /*
+     * Blocks until a buffer newer than the last one locked for
+     * reading by this object is published or the timeout (in
+     * seconds) expires. Returns false on timeout. Waiting is done
+     * on a futex in the segment, so no cpu time is burned and the
+     * waiter is woken up as soon as the writer unlocks the buffer.
+     */
+    bool _waitNewer(float timeout);
+
+    /*
+     * The publish and acquire time (seconds of CLOCK_MONOTONIC) of
+     * the data in the buffer returned by the last successful lock.
+     * When locked for writing these belong to the data that is
+     * about to be overwritten, an acquire time of 0 means it was
+     * never read. Returns false if the buffer held no data yet.
+     */
+    bool _lockedStamps(double& publishTime, double& acquireTime);
+
     ~SHMCommPrivate();
 private:
 
     void * shmPtr;
     int shmId;
     int key;
+    SegmentHeader * header;
     Buffer * buffers[NBUFFERS];
-    uint64_t gWriteId;
+    int bufferCount;
     size_t buffersize;
     size_t shmsize;
+    size_t mappedSize;
+    bool describedBySegment;
+    uint64_t lastReadId;
+    uint64_t lockedPublishTime;
+    uint64_t lockedAcquireTime;
+    Backend backend;
+    bool hugePages;
+
+    bool mapSegment(size_t size, bool& created, bool& sizeMismatch);
+    bool mapExistingSegment();
+    void removeSegment();
+    void invalidateSegment();
+    bool openPosix(int flags, bool& hugetlb);
+    bool attachExisting();
+    void mapBuffers();
+    void initialize();
+    bool waitForInitialization();
+    bool tryLock(Buffer * buffer, BufferState from, BufferState to);
+    bool reclaimStaleBuffers();
+    void takeOverwrittenStamps(Buffer * buffer);
+    void *lockOnce(LockMode mode);
 };
 
 template <typename DataType>
@@ -51,6 +173,17 @@ class SHMComm{
 public:
     SHMComm(int key) : p(key, sizeof(DataType)){
 
+    }
+    /*
+     * For channels whose size is only known at runtime. Each buffer
+     * holds a DataType followed by size - sizeof(DataType) bytes.
+     */
+    SHMComm(int key, size_t size, int bufferCount = NBUFFERS)
+        : p(key, size, bufferCount){
+
+    }
+    void setBackend(Backend backend, bool hugePages = false){
+        p.setBackend(backend, hugePages);
     }
     void detach(){
         p.detach();
@@ -61,12 +194,33 @@ public:
     bool attach(){
         return p._attach();
     }
+    bool create(size_t size, int bufferCount = NBUFFERS){
+        return p._create(size, bufferCount);
+    }
+    bool invalidated(){
+        return p._invalidated();
+    }
+    int key(){
+        return p._key();
+    }
+    size_t size(){
+        return p._bufferSize();
+    }
+    int bufferCount(){
+        return p._bufferCount();
+    }
     DataType *lock(LockMode mode){
         return (DataType*)p._lock(mode);
     }
     void unlock(DataType * buffer){
         p._unlock(buffer);
     }
+    bool waitNewer(float timeout){
+        return p._waitNewer(timeout);
+    }
+    bool lockedStamps(double& publishTime, double& acquireTime){
+        return p._lockedStamps(publishTime, acquireTime);
+    }
 private:
 
     SHMCommPrivate p;